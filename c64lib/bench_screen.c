@@ -0,0 +1,75 @@
+/*
+ * c64screen benchmark: exact cycle counts for the conio call sequences
+ * hello_world and the fireworks status line used, next to the c64screen
+ * calls that replaced them, timed with ciatimer.c.
+ */
+
+#include <c64.h>
+#include <conio.h>
+#include <stdio.h>
+
+#include "c64screen.h"
+#include "ciatimer.h"
+
+#define NUM_CASES 3
+
+static const char *const case_names[NUM_CASES] = {"clear", "hello",
+                                                  "status"};
+static unsigned long conio_cycles[NUM_CASES];
+static unsigned long scr_cycles[NUM_CASES];
+
+/* The same texts as screen codes */
+#include <cbm_screen_charmap.h>
+static const char hello_scr[] = "Hello, C64 World!";
+static const char status_scr[] = "SPACE:Launch Q:Quit";
+#include <cbm_petscii_charmap.h>
+
+void run_benchmarks(void) {
+  timer_calibrate();
+
+  timer_start();
+  clrscr();
+  conio_cycles[0] = timer_stop();
+  timer_start();
+  scr_fill(SCR_SPACE, 14);
+  scr_cycles[0] = timer_stop();
+
+  /* hello_world's greeting */
+  timer_start();
+  gotoxy(11, 5);
+  textcolor(3);
+  cprintf("Hello, C64 World!");
+  conio_cycles[1] = timer_stop();
+  timer_start();
+  scr_puts(11, 5, 3, hello_scr);
+  scr_cycles[1] = timer_stop();
+
+  /* fireworks' status line */
+  timer_start();
+  gotoxy(0, 24);
+  textcolor(15);
+  cprintf("SPACE:Launch Q:Quit");
+  conio_cycles[2] = timer_stop();
+  timer_start();
+  scr_puts(0, 24, 15, status_scr);
+  scr_cycles[2] = timer_stop();
+}
+
+int main(void) {
+  unsigned char i;
+
+  VIC.ctrl1 &= 0xef; /* blank screen: no badlines */
+  __asm__("sei");
+  run_benchmarks();
+  __asm__("cli");
+  VIC.ctrl1 |= 0x10;
+
+  clrscr();
+  printf("c64screen benchmark (cycles)\n\n");
+  printf("%-7s %8s %8s %6s\n", "case", "conio", "screen", "x");
+  for (i = 0; i < NUM_CASES; ++i) {
+    printf("%-7s %8lu %8lu %6lu\n", case_names[i], conio_cycles[i],
+           scr_cycles[i], conio_cycles[i] / scr_cycles[i]);
+  }
+  return 0;
+}
@@ -0,0 +1,37 @@
+/*
+ * Direct text screen output (c64screen.s), a light replacement for the
+ * conio clrscr/gotoxy/textcolor/cprintf sequence on the screen at $0400.
+ *
+ * Strings passed to scr_puts must already be screen codes. Define them
+ * between the cc65 charmap headers and the compiler converts them:
+ *
+ *   #include <cbm_screen_charmap.h>
+ *   static const char title[] = "Hello";
+ *   #include <cbm_petscii_charmap.h>
+ *
+ * '@' is screen code 0, the terminator, so it cannot appear in them.
+ */
+
+#ifndef C64SCREEN_H
+#define C64SCREEN_H
+
+#define SCR_W 40
+#define SCR_H 25
+#define SCR_SPACE 0x20
+
+/* Screen address of the start of each row */
+extern const unsigned char scr_row_lo[SCR_H];
+extern const unsigned char scr_row_hi[SCR_H];
+
+/* All 1000 cells to screen code `code`, colour RAM to `color` */
+void __fastcall__ scr_fill(unsigned char code, unsigned char color);
+
+/* Screen-code string at column x, row y, in `color`; no wrapping */
+void __fastcall__ scr_puts(unsigned char x, unsigned char y,
+                           unsigned char color, const char *s);
+
+/* Recolours len cells from column x, row y */
+void __fastcall__ scr_color(unsigned char x, unsigned char y,
+                            unsigned char len, unsigned char color);
+
+#endif /* C64SCREEN_H */
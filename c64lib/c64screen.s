@@ -0,0 +1,118 @@
+;
+; Direct text screen output for the screen at $0400 and colour RAM.
+;
+; Strings are screen codes already (see c64screen.h), so nothing is
+; converted at run time, and every call finds its cell through the
+; scr_row_lo/scr_row_hi tables, built by the assembler. scr_fill clears
+; all 1000 cells with four stores per loop pass.
+;
+
+        .export         _scr_fill, _scr_puts, _scr_color
+        .export         _scr_row_lo, _scr_row_hi
+        .import         popa
+        .importzp       ptr1, ptr2, ptr3, tmp1
+
+SCREEN          = $0400
+COLRAM          = $D800
+SCREEN_W        = 40
+SCREEN_H        = 25
+QUARTER         = SCREEN_W * SCREEN_H / 4
+
+.segment        "RODATA"
+
+_scr_row_lo:
+.repeat SCREEN_H, r
+        .byte   <(SCREEN + r * SCREEN_W)
+.endrepeat
+_scr_row_hi:
+.repeat SCREEN_H, r
+        .byte   >(SCREEN + r * SCREEN_W)
+.endrepeat
+
+.segment        "CODE"
+
+; void __fastcall__ scr_fill (unsigned char code, unsigned char color);
+.proc   _scr_fill
+        sta     tmp1
+        jsr     popa
+        ldx     #QUARTER
+@code:  sta     SCREEN-1,x
+        sta     SCREEN-1+QUARTER,x
+        sta     SCREEN-1+QUARTER*2,x
+        sta     SCREEN-1+QUARTER*3,x
+        dex
+        bne     @code
+        lda     tmp1
+        ldx     #QUARTER
+@color: sta     COLRAM-1,x
+        sta     COLRAM-1+QUARTER,x
+        sta     COLRAM-1+QUARTER*2,x
+        sta     COLRAM-1+QUARTER*3,x
+        dex
+        bne     @color
+        rts
+.endproc
+
+; Points ptr2 at screen cell (A, Y) and ptr3 at its colour RAM byte.
+.proc   cell
+        clc
+        adc     _scr_row_lo,y
+        sta     ptr2
+        sta     ptr3
+        lda     _scr_row_hi,y
+        adc     #0
+        sta     ptr2+1
+        adc     #>(COLRAM - SCREEN)     ; C = 0
+        sta     ptr3+1
+        rts
+.endproc
+
+; void __fastcall__ scr_puts (unsigned char x, unsigned char y,
+;                             unsigned char color, const char *s);
+.proc   _scr_puts
+        sta     ptr1
+        stx     ptr1+1
+        jsr     popa
+        sta     tmp1                    ; color
+        jsr     popa
+        pha                             ; y
+        jsr     popa                    ; x
+        tax
+        pla
+        tay
+        txa
+        jsr     cell
+        ldy     #0
+@loop:  lda     (ptr1),y
+        beq     @done
+        sta     (ptr2),y
+        lda     tmp1
+        sta     (ptr3),y
+        iny
+        bne     @loop
+@done:  rts
+.endproc
+
+; void __fastcall__ scr_color (unsigned char x, unsigned char y,
+;                              unsigned char len, unsigned char color);
+.proc   _scr_color
+        sta     tmp1                    ; color
+        jsr     popa
+        pha                             ; len
+        jsr     popa
+        pha                             ; y
+        jsr     popa                    ; x
+        tax
+        pla
+        tay
+        txa
+        jsr     cell
+        pla
+        tay
+        beq     @done
+        lda     tmp1
+@loop:  dey
+        sta     (ptr3),y
+        bne     @loop
+@done:  rts
+.endproc
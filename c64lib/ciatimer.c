@@ -0,0 +1,35 @@
+/*
+ * 32-bit cycle counter on CIA2 timers A and B (see ciatimer.h).
+ */
+
+#include <c64.h>
+
+#include "ciatimer.h"
+
+static unsigned long overhead = 0;
+
+void timer_start(void) {
+  CIA2.cra = 0x00;
+  CIA2.crb = 0x00;
+  CIA2.ta_lo = 0xff;
+  CIA2.ta_hi = 0xff;
+  CIA2.tb_lo = 0xff;
+  CIA2.tb_hi = 0xff;
+  CIA2.crb = 0x51; /* force load, count timer A underflows, start */
+  CIA2.cra = 0x11; /* force load, count phi2, start */
+}
+
+unsigned long timer_stop(void) {
+  unsigned int lo, hi;
+
+  CIA2.cra = 0x00; /* timer B stops with A */
+  lo = CIA2.ta_lo | (CIA2.ta_hi << 8);
+  hi = CIA2.tb_lo | (CIA2.tb_hi << 8);
+  return 0xffffffffUL - (((unsigned long)hi << 16) | lo) - overhead;
+}
+
+void timer_calibrate(void) {
+  overhead = 0;
+  timer_start();
+  overhead = timer_stop();
+}
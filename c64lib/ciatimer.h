@@ -0,0 +1,22 @@
+/*
+ * 32-bit cycle counter on CIA2 (ciatimer.c), for the benchmarks.
+ *
+ * Timer A counts system clocks and timer B counts timer A underflows.
+ * Callers mask IRQs and blank the screen while timing, so neither the
+ * KERNAL nor VIC-II badlines steal cycles from the code being measured.
+ */
+
+#ifndef CIATIMER_H
+#define CIATIMER_H
+
+/* Measures the cost of a timer_start/timer_stop pair, which timer_stop
+ * subtracts from then on. Call once before timing anything. */
+void timer_calibrate(void);
+
+/* Loads both timers with $FFFF and starts them */
+void timer_start(void);
+
+/* Cycles since timer_start */
+unsigned long timer_stop(void);
+
+#endif /* CIATIMER_H */
@@ -0,0 +1,19 @@
+# Self-extracting crunched PRGs, shared by the project Makefiles.
+#
+# Include after LIB is set and after the first target, then list
+# <name>_lz.prg files as prerequisites. Each is <name>.prg packed by
+# lzpack behind the lzsfx.s decoder stub, and loads as a normal PRG.
+
+HOSTCC ?= cc
+
+LZPACK = $(LIB)/lzpack
+LZSFX = $(LIB)/lzsfx.prg
+
+$(LZPACK): $(LIB)/lzpack.c
+	$(HOSTCC) -O2 -Wall -o $@ $<
+
+$(LZSFX): $(LIB)/lzsfx.s
+	cl65 -t c64 -C c64-asm.cfg -u __EXEHDR__ -o $@ $<
+
+%_lz.prg: %.prg $(LZPACK) $(LZSFX)
+	$(LZPACK) $(LZSFX) $< $@
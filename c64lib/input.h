@@ -0,0 +1,60 @@
+/*
+ * CIA1 keyboard and joystick scanner (input.s).
+ *
+ * in_scan runs once per interrupt and queues debounced press and release
+ * events; the program drains them with in_get. Programs with their own
+ * raster IRQ call in_init and jsr in_scan from it; others use in_start
+ * and in_stop.
+ */
+
+#ifndef INPUT_H
+#define INPUT_H
+
+/* in_get: nothing queued */
+#define IN_NONE 0xFF
+/* Set in release events */
+#define IN_RELEASE 0x80
+
+/* Key events are matrix positions: column (CIA1 port A bit) * 8 + row
+ * (port B bit).
+ *
+ *        row 0   1     2     3     4      5    6    7
+ * col 0  DEL     RET   CRSR> F7    F1     F3   F5   CRSRv
+ * col 1  3       W     A     4     Z      S    E    LSHIFT
+ * col 2  5       R     D     6     C      F    T    X
+ * col 3  7       Y     G     8     B      H    U    V
+ * col 4  9       I     J     0     M      K    O    N
+ * col 5  +       P     L     -     .      :    @    ,
+ * col 6  POUND   *     ;     HOME  RSHIFT =    ^    /
+ * col 7  1       <-    CTRL  2     SPACE  C=   Q    STOP
+ */
+#define IN_KEY(col, row) ((col) * 8 + (row))
+#define IN_KEY_RETURN IN_KEY(0, 1)
+#define IN_KEY_SPACE IN_KEY(7, 4)
+#define IN_KEY_Q IN_KEY(7, 6)
+#define IN_KEY_STOP IN_KEY(7, 7)
+
+/* Joystick events: port base plus line */
+#define IN_JOY2 64
+#define IN_JOY1 72
+#define IN_JOY_UP 0
+#define IN_JOY_DOWN 1
+#define IN_JOY_LEFT 2
+#define IN_JOY_RIGHT 3
+#define IN_JOY_FIRE 4
+
+/* Empties the event ring and takes the current keys as the starting
+ * state: a key already down, such as RETURN from RUN, gives only its
+ * release event */
+void in_init(void);
+
+/* in_init, then scans from the KERNAL interrupt (60 Hz) */
+void in_start(void);
+
+/* Undoes in_start if used; drops keys the KERNAL buffered meanwhile */
+void in_stop(void);
+
+/* Next event, or IN_NONE */
+unsigned char in_get(void);
+
+#endif /* INPUT_H */
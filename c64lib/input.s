@@ -0,0 +1,224 @@
+;
+; CIA1 keyboard matrix and joystick scanner with a debounced event ring.
+;
+; in_scan reads the whole 8x8 keyboard matrix and both joysticks straight
+; from CIA1. Call it once per interrupt, e.g. from a raster IRQ, or use
+; in_start to run it from the KERNAL interrupt. A key or joystick line
+; counts as pressed once two scans in a row see it down, and as released
+; once two scans in a row see it up. Every change of that debounced state
+; becomes one event byte in a 16-entry ring. The main program drains the
+; ring with in_get, so keys pressed while it is busy are not lost.
+;
+; Event codes (input.h): column * 8 + row for keys, IN_JOY2/IN_JOY1 plus
+; the line number for joysticks, plus IN_RELEASE ($80) on release.
+; A moving joystick pulls matrix lines low, so keyboard state is held
+; while either joystick reads as active.
+;
+
+        .export         _in_init, _in_get, _in_start, _in_stop
+        .export         in_scan
+
+CIA1_PRA        = $DC00                 ; keyboard columns out, joystick 2
+CIA1_PRB        = $DC01                 ; keyboard rows in, joystick 1
+IRQ_VECTOR      = $0314
+KERNAL_KEYS     = $C6                   ; KERNAL keyboard buffer length
+
+QUEUE_SIZE      = 16                    ; power of two
+SCAN_BYTES      = 10                    ; 8 columns, joystick 2, joystick 1
+IN_NONE         = $FF
+IN_RELEASE      = $80
+
+.segment        "RODATA"
+
+col_select:     .byte   $FE, $FD, $FB, $F7, $EF, $DF, $BF, $7F
+
+.segment        "BSS"
+
+now:            .res    SCAN_BYTES      ; this scan, bit set = down
+last:           .res    SCAN_BYTES      ; previous scan
+state:          .res    SCAN_BYTES      ; debounced
+queue:          .res    QUEUE_SIZE
+q_head:         .res    1               ; next free slot, written by in_scan
+q_tail:         .res    1               ; next event, written by in_get
+changed:        .res    1
+down:           .res    1
+code:           .res    1
+old_irq:        .res    2               ; high byte 0: not hooked
+
+.segment        "CODE"
+
+; void in_init (void);
+; Starts from one scan taken as the debounced state, so keys already down,
+; such as RETURN from RUN, give no press events.
+.proc   _in_init
+        lda     #0
+        ldx     #7
+@clear: sta     state,x                 ; keys read as up behind a joystick
+        dex
+        bpl     @clear
+        php
+        sei                             ; the KERNAL scan also drives CIA1
+        jsr     read
+        plp
+        ldx     #SCAN_BYTES-1
+@seed:  lda     now,x
+        sta     last,x
+        sta     state,x
+        dex
+        bpl     @seed
+        lda     #0
+        sta     q_head
+        sta     q_tail
+        rts
+.endproc
+
+; void in_start (void);
+; For programs without their own interrupt: in_init, then runs in_scan in
+; front of the KERNAL interrupt handler.
+.proc   _in_start
+        jsr     _in_init
+        sei
+        lda     IRQ_VECTOR
+        sta     old_irq
+        lda     IRQ_VECTOR+1
+        sta     old_irq+1
+        lda     #<scan_isr
+        sta     IRQ_VECTOR
+        lda     #>scan_isr
+        sta     IRQ_VECTOR+1
+        cli
+        rts
+.endproc
+
+; void in_stop (void);
+; Unhooks in_start, if it was used, and empties the KERNAL keyboard
+; buffer, which the KERNAL interrupt kept filling meanwhile, so the keys
+; do not reach BASIC.
+.proc   _in_stop
+        sei
+        lda     old_irq+1
+        beq     @flush
+        sta     IRQ_VECTOR+1
+        lda     old_irq
+        sta     IRQ_VECTOR
+        lda     #0
+        sta     old_irq+1
+@flush: lda     #0
+        sta     KERNAL_KEYS
+        cli
+        rts
+.endproc
+
+.proc   scan_isr
+        jsr     in_scan
+        jmp     (old_irq)
+.endproc
+
+; unsigned char in_get (void);
+; Next event, or IN_NONE.
+.proc   _in_get
+        ldy     q_tail
+        cpy     q_head
+        beq     @none
+        lda     queue,y
+        tax
+        iny
+        tya
+        and     #QUEUE_SIZE-1
+        sta     q_tail
+        txa
+        ldx     #0
+        rts
+@none:  lda     #IN_NONE
+        ldx     #0
+        rts
+.endproc
+
+; Scans keyboard and joysticks and queues debounced changes. Clobbers A,
+; X and Y.
+.proc   in_scan
+        jsr     read
+        ldx     #SCAN_BYTES-1
+@byte:  lda     now,x                   ; down in both scans, or held and
+        and     last,x                  ; down in either
+        sta     down
+        lda     now,x
+        ora     last,x
+        and     state,x
+        ora     down
+        sta     down
+        eor     state,x
+        beq     @same
+        sta     changed
+        lda     down
+        sta     state,x
+        txa
+        asl     a
+        asl     a
+        asl     a
+        sta     code                    ; X * 8 + bit
+@bit:   lsr     down
+        lda     #IN_RELEASE
+        bcc     @up
+        lda     #0
+@up:    ora     code
+        lsr     changed
+        bcc     @next
+        jsr     push
+@next:  inc     code
+        lda     changed
+        bne     @bit
+@same:  lda     now,x
+        sta     last,x
+        dex
+        bpl     @byte
+        rts
+.endproc
+
+; Reads keyboard and joysticks into now, bit set = down. Clobbers A and X.
+.proc   read
+        lda     #$FF                    ; no column selected
+        sta     CIA1_PRA
+        lda     CIA1_PRA
+        eor     #$FF
+        and     #$1F
+        sta     now+8
+        lda     CIA1_PRB
+        eor     #$FF
+        and     #$1F
+        sta     now+9
+        ora     now+8
+        beq     @keys
+        ldx     #7                      ; joystick active: hold the keys
+@hold:  lda     state,x
+        sta     now,x
+        sta     last,x
+        dex
+        bpl     @hold
+        rts
+
+@keys:  ldx     #7
+@col:   lda     col_select,x
+        sta     CIA1_PRA
+        lda     CIA1_PRB
+        eor     #$FF
+        sta     now,x
+        dex
+        bpl     @col
+        lda     #$FF
+        sta     CIA1_PRA
+        rts
+.endproc
+
+; Queues event A; dropped when the ring is full. Keeps X.
+.proc   push
+        ldy     q_head
+        sta     queue,y
+        iny
+        tya
+        and     #QUEUE_SIZE-1
+        cmp     q_tail
+        beq     @full
+        sta     q_head
+@full:  rts
+.endproc
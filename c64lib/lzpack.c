@@ -0,0 +1,255 @@
+/*
+ * Packs a cc65 PRG into a self-extracting PRG (host tool).
+ *
+ * The program after its load address is compressed into the LZ stream
+ * that lzsfx.s decodes: literal runs of up to 128 bytes, and copies of
+ * 4-130 bytes from up to 64K back in the output. Matches are found
+ * through hash chains over every earlier position, and one step of lazy
+ * matching defers a match when the next byte starts a longer one. The
+ * stream is decoded again here and compared with the input before the
+ * output is written.
+ *
+ * usage: lzpack lzsfx.prg in.prg out.prg
+ *
+ * lzsfx.prg is the assembled stub. The program must load at $0801 and
+ * start with a BASIC SYS line, as cc65 programs do; the stub enters it
+ * through that address once the stream is decoded. Prints the sizes
+ * before and after, in bytes and 254-byte disk blocks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Keep in sync with lzsfx.s */
+#define STREAM_END 0xD000UL
+#define DECODER_END (0x033CUL + 192)
+#define MIN_MATCH 4
+#define MAX_MATCH (0x7E + MIN_MATCH)
+#define MAX_LITERAL 128
+#define END_TOKEN 0xFF
+
+#define MAX_PRG 65538
+#define HASH_SIZE 65536
+#define MAX_CHAIN 4096
+#define NO_POS (-1L)
+
+static unsigned char stub[MAX_PRG], prg[MAX_PRG], out[2 * MAX_PRG];
+static unsigned char check[MAX_PRG];
+static long head[HASH_SIZE], prev[MAX_PRG];
+
+static long read_file(const char *path, unsigned char *buf) {
+  FILE *f = fopen(path, "rb");
+  long n;
+
+  if (f == NULL) {
+    perror(path);
+    return -1;
+  }
+  n = (long)fread(buf, 1, MAX_PRG, f);
+  if (!feof(f)) {
+    fprintf(stderr, "%s: larger than a PRG\n", path);
+    n = -1;
+  }
+  fclose(f);
+  if (n >= 0 && n < 3) {
+    fprintf(stderr, "%s: too short for a PRG\n", path);
+    n = -1;
+  }
+  return n;
+}
+
+static unsigned long word(const unsigned char *p) {
+  return p[0] | (unsigned long)p[1] << 8;
+}
+
+static void put_word(unsigned char *p, unsigned long v) {
+  p[0] = (unsigned char)v;
+  p[1] = (unsigned char)(v >> 8);
+}
+
+/* Address after SYS in the first BASIC line of a PRG loading at $0801 */
+static int sys_address(const unsigned char *p, long n, unsigned long *addr) {
+  long i;
+
+  if (word(p) != 0x0801)
+    return -1;
+  for (i = 6; i < n && p[i] != 0x9E; ++i) /* after link and line number */
+    if (p[i] == 0)
+      return -1;
+  for (++i; i < n && p[i] == ' '; ++i)
+    ;
+  if (i == n || p[i] < '0' || p[i] > '9')
+    return -1;
+  for (*addr = 0; i < n && p[i] >= '0' && p[i] <= '9'; ++i)
+    *addr = *addr * 10 + (p[i] - '0');
+  return 0;
+}
+
+static unsigned int hash(const unsigned char *p) {
+  return p[0] | (unsigned int)p[1] << 8;
+}
+
+/* Longest earlier match at pos: length in *len, 0 if shorter than
+ * MIN_MATCH, and the distance back as the return value */
+static long find_match(const unsigned char *p, long pos, long n,
+                       long *len) {
+  long cand, best = 0, dist = 0, max = n - pos, l;
+  int chain = MAX_CHAIN;
+
+  *len = 0;
+  if (max < MIN_MATCH)
+    return 0;
+  if (max > MAX_MATCH)
+    max = MAX_MATCH;
+  for (cand = head[hash(p + pos)]; cand != NO_POS && chain--;
+       cand = prev[cand]) {
+    if (pos - cand > 0xFFFF)
+      break;
+    for (l = 0; l < max && p[cand + l] == p[pos + l]; ++l)
+      ;
+    if (l > best) {
+      best = l;
+      dist = pos - cand;
+      if (l == max)
+        break;
+    }
+  }
+  if (best < MIN_MATCH)
+    return 0;
+  *len = best;
+  return dist;
+}
+
+static void insert(const unsigned char *p, long pos, long n) {
+  unsigned int h;
+
+  if (pos + 1 >= n)
+    return;
+  h = hash(p + pos);
+  prev[pos] = head[h];
+  head[h] = pos;
+}
+
+static long compress(const unsigned char *p, long n, unsigned char *o) {
+  long pos = 0, lit = 0, size = 0, len, dist, next_len, i;
+
+  for (i = 0; i < HASH_SIZE; ++i)
+    head[i] = NO_POS;
+  while (pos < n) {
+    dist = find_match(p, pos, n, &len);
+    insert(p, pos, n);
+    if (len && len < MAX_MATCH) {
+      find_match(p, pos + 1, n, &next_len);
+      if (next_len > len)
+        len = 0; /* a literal, then the longer match */
+    }
+    if (len == 0) {
+      if (lit == 0)
+        o[size++] = 0; /* token, counted up as literals follow */
+      o[size++] = p[pos++];
+      o[size - lit - 2] = (unsigned char)lit;
+      if (++lit == MAX_LITERAL)
+        lit = 0;
+      continue;
+    }
+    lit = 0;
+    o[size++] = (unsigned char)(0x80 | (len - MIN_MATCH));
+    o[size++] = (unsigned char)dist;
+    o[size++] = (unsigned char)(dist >> 8);
+    for (i = 1; i < len; ++i)
+      insert(p, pos + i, n);
+    pos += len;
+  }
+  o[size++] = END_TOKEN;
+  return size;
+}
+
+static long decompress(const unsigned char *s, long n, unsigned char *o) {
+  long i = 0, size = 0, len, dist;
+  unsigned char t;
+
+  while (i < n && (t = s[i++]) != END_TOKEN) {
+    if (t < 0x80) {
+      for (len = t + 1; len--;)
+        o[size++] = s[i++];
+    } else {
+      len = (t & 0x7F) + MIN_MATCH;
+      dist = s[i] | (long)s[i + 1] << 8;
+      i += 2;
+      if (dist == 0 || dist > size)
+        return -1;
+      for (; len--; ++size)
+        o[size] = o[size - dist];
+    }
+  }
+  return size;
+}
+
+static long blocks(long bytes) { return (bytes + 253) / 254; }
+
+int main(int argc, char **argv) {
+  long stub_n, prg_n, body_n, packed_n, total;
+  unsigned long entry, load, stream, moved, code;
+  FILE *f;
+
+  if (argc != 4) {
+    fprintf(stderr, "usage: lzpack lzsfx.prg in.prg out.prg\n");
+    return 2;
+  }
+  if ((stub_n = read_file(argv[1], stub)) < 0 ||
+      (prg_n = read_file(argv[2], prg)) < 0)
+    return 1;
+  stream = word(stub) + stub_n - 2; /* right behind the stub */
+  if (sys_address(stub, stub_n, &code) != 0 || code + 11 > stream ||
+      stub[code - 0x0801 + 2] != 0x4C || /* jmp over the parameters */
+      word(stub + code - 0x0801 + 5) != stream) {
+    fprintf(stderr, "%s: not an lzsfx stub\n", argv[1]);
+    return 1;
+  }
+  if (sys_address(prg, prg_n, &entry) != 0) {
+    fprintf(stderr, "%s: no SYS line at $0801\n", argv[2]);
+    return 1;
+  }
+
+  load = word(prg);
+  body_n = prg_n - 2;
+  packed_n = compress(prg + 2, body_n, out);
+  if (decompress(out, packed_n, check) != body_n ||
+      memcmp(check, prg + 2, body_n) != 0) {
+    fprintf(stderr, "%s: stream does not decode back\n", argv[2]);
+    return 1;
+  }
+
+  /* The stream is moved up to end at STREAM_END, clear of its load
+   * position, and the program is decoded below it */
+  moved = STREAM_END - packed_n;
+  if (stream + packed_n > moved || load + body_n > moved ||
+      load < DECODER_END) {
+    fprintf(stderr, "%s: too large to decode in place\n", argv[2]);
+    return 1;
+  }
+  put_word(stub + code - 0x0801 + 7, packed_n);
+  put_word(stub + code - 0x0801 + 9, load);
+  put_word(stub + code - 0x0801 + 11, entry);
+
+  f = fopen(argv[3], "wb");
+  if (f == NULL) {
+    perror(argv[3]);
+    return 1;
+  }
+  if (fwrite(stub, 1, stub_n, f) != (size_t)stub_n ||
+      fwrite(out, 1, packed_n, f) != (size_t)packed_n) {
+    perror(argv[3]);
+    fclose(f);
+    return 1;
+  }
+  if (fclose(f) != 0) {
+    perror(argv[3]);
+    return 1;
+  }
+  total = stub_n + packed_n;
+  printf("%s: %ld bytes (%ld blocks) -> %s: %ld bytes (%ld blocks)\n",
+         argv[2], prg_n, blocks(prg_n), argv[3], total, blocks(total));
+  return 0;
+}
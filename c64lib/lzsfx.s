@@ -0,0 +1,181 @@
+;
+; Self-extracting header for PRGs packed by lzpack.c.
+;
+; lzpack appends the packed stream right after this stub and fills in the
+; parameter block behind the jmp at the SYS address. At run time the stub
+; moves the stream up against STREAM_END, with BASIC ROM banked out so
+; $A000-$BFFF reads back as RAM, copies the decoder to the cassette
+; buffer and decodes the stream forward to the program's load address.
+; lzpack checks that the program ends below the moved stream, so the
+; decoder never overwrites bytes it has yet to read. Then the end of the
+; program goes to the BASIC variables pointer as a plain LOAD would leave
+; it, $01 is restored and the program starts through its own SYS address.
+;
+; Stream format, one token byte t at a time:
+;   $00-$7F     t + 1 literal bytes follow
+;   $80-$FE     copy (t & $7F) + 4 bytes from the offset (lo, hi) back
+;   $FF         end of stream
+;
+; Built as a plain assembler program:
+;   cl65 -t c64 -C c64-asm.cfg -u __EXEHDR__ -o lzsfx.prg lzsfx.s
+;
+
+; Keep in sync with lzpack.c
+STREAM_END      = $D000
+DECODER         = $033C                 ; cassette buffer
+DECODER_SIZE    = 192
+MIN_MATCH       = 4
+
+VARTAB          = $2D
+
+; Free while nothing else runs: RS-232 buffer pointers and user zero page
+src             = $F7
+dst             = $F9
+ref             = $FB
+len             = $FD
+
+.segment        "CODE"
+
+        jmp     start
+
+; Parameter block, filled in by lzpack
+stream_addr:    .word   stream          ; checked by lzpack
+stream_len:     .word   0
+load_addr:      .word   0
+entry_addr:     .word   0
+
+start:  sei
+        ldx     #0
+@code:  lda     decoder_load,x
+        sta     DECODER,x
+        inx
+        cpx     #decoder_end - DECODER
+        bne     @code
+        lda     entry_addr
+        sta     enter+1
+        lda     entry_addr+1
+        sta     enter+2
+        lda     $01
+        sta     restore+1
+        and     #$FE                    ; BASIC ROM out
+        sta     $01
+
+        ; Stream up to STREAM_END - stream_len; lzpack keeps the two
+        ; ranges apart, so a forward copy is safe
+        lda     #<stream
+        sta     src
+        lda     #>stream
+        sta     src+1
+        sec
+        lda     #<STREAM_END
+        sbc     stream_len
+        sta     dst
+        sta     ref
+        lda     #>STREAM_END
+        sbc     stream_len+1
+        sta     dst+1
+        sta     ref+1
+        ldy     #0
+        ldx     stream_len+1
+        beq     @tail
+@page:  lda     (src),y
+        sta     (dst),y
+        iny
+        bne     @page
+        inc     src+1
+        inc     dst+1
+        dex
+        bne     @page
+@tail:  cpy     stream_len
+        beq     @moved
+        lda     (src),y
+        sta     (dst),y
+        iny
+        bne     @tail                   ; always, Y < 256
+
+@moved: lda     ref
+        sta     src
+        lda     ref+1
+        sta     src+1
+        lda     load_addr
+        sta     dst
+        lda     load_addr+1
+        sta     dst+1
+        jmp     DECODER
+
+decoder_load:
+        .org    DECODER
+
+token:  ldy     #0
+        lda     (src),y
+        inc     src
+        bne     @got
+        inc     src+1
+@got:   cmp     #$80
+        bcs     @match
+        adc     #1                      ; C clear: t + 1 literals
+        sta     len
+@lit:   lda     (src),y
+        sta     (dst),y
+        iny
+        cpy     len
+        bne     @lit
+        tya
+        clc
+        adc     src
+        sta     src
+        bcc     advance
+        inc     src+1
+        bcs     advance                 ; always
+
+@match: and     #$7F
+        cmp     #$7F
+        beq     done
+        adc     #MIN_MATCH              ; C clear
+        sta     len
+        lda     dst
+        sec
+        sbc     (src),y
+        sta     ref
+        iny
+        lda     dst+1
+        sbc     (src),y
+        sta     ref+1
+        lda     src
+        clc
+        adc     #2
+        sta     src
+        bcc     @from
+        inc     src+1
+@from:  ldy     #0
+@copy:  lda     (ref),y                 ; may overlap dst: copies forward
+        sta     (dst),y
+        iny
+        cpy     len
+        bne     @copy
+
+advance:
+        tya
+        clc
+        adc     dst
+        sta     dst
+        bcc     token
+        inc     dst+1
+        bne     token                   ; always, output ends below $D000
+
+done:   lda     dst
+        sta     VARTAB
+        lda     dst+1
+        sta     VARTAB+1
+restore:
+        lda     #$37
+        sta     $01
+        cli
+enter:  jmp     $0000
+
+decoder_end:
+        .reloc
+
+.assert decoder_end - DECODER <= DECODER_SIZE, error, "decoder does not fit the cassette buffer"
+
+stream:
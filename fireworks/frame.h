@@ -0,0 +1,25 @@
+/*
+ * Raster IRQ frame clock (frame.s).
+ */
+
+#ifndef FRAME_H
+#define FRAME_H
+
+/* Raster line the frame interrupt fires on (bottom border) */
+#define FRAME_IRQ_LINE 251
+
+/* Incremented once per video frame by the raster IRQ */
+extern volatile unsigned char frame_ticks;
+
+#ifdef FW_DOUBLE
+/* $D018 value for the frame IRQ to switch to, cleared once done */
+extern volatile unsigned char frame_flip;
+#endif
+
+void frame_init(void);
+void frame_shutdown(void);
+
+/* Current raster line (0-311 PAL, 0-262 NTSC) */
+unsigned int frame_raster(void);
+
+#endif /* FRAME_H */
@@ -0,0 +1,148 @@
+;
+; Raster IRQ frame clock for the fireworks main loop.
+;
+; A VIC-II raster interrupt at FRAME_IRQ_LINE (bottom border, below the
+; last text row) bumps frame_ticks once per video frame, 50 Hz on PAL and
+; 60 Hz on NTSC. The handler sits in front of the KERNAL IRQ vector:
+; raster interrupts are acknowledged and returned from directly, anything
+; else (the CIA1 timer that drives the keyboard scan) falls through to the
+; previous handler.
+;
+; Every frame tick also runs the sound driver (snd_tick in sound.s) and
+; the keyboard and joystick scanner (in_scan in ../c64lib/input.s).
+;
+; With FW_SPRITES defined the same interrupt also drives the sprite
+; multiplexer (sprmux.s): the frame line hands over to mux_frame, which
+; may re-arm the raster compare for split lines further down the next
+; frame; the last split re-arms FRAME_IRQ_LINE.
+;
+; With FW_DOUBLE defined, a nonzero frame_flip is written to $D018 at the
+; frame line (showing the buffer the main loop just finished) and cleared.
+;
+
+        .export         _frame_init, _frame_shutdown, _frame_raster
+        .export         _frame_ticks
+        .import         snd_tick, in_scan
+.ifdef FW_SPRITES
+        .import         mux_frame, mux_split
+.endif
+.ifdef FW_DOUBLE
+        .export         _frame_flip
+.endif
+
+FRAME_IRQ_LINE  = 251
+
+VIC_CTRL1       = $D011
+VIC_RASTER      = $D012
+VIC_ADDR        = $D018
+VIC_IRR         = $D019
+VIC_IMR         = $D01A
+IRQ_VECTOR      = $0314
+KERNAL_IRQ_EXIT = $EA81                 ; pull Y, X, A and RTI
+
+.segment        "BSS"
+
+_frame_ticks:   .res    1
+old_irq:        .res    2
+.ifdef FW_SPRITES
+split_line:     .res    1               ; armed line, 0 = frame line
+.endif
+.ifdef FW_DOUBLE
+_frame_flip:    .res    1               ; $D018 value to show, 0 = none
+.endif
+
+.segment        "CODE"
+
+; void frame_init (void);
+.proc   _frame_init
+        sei
+        lda     IRQ_VECTOR
+        sta     old_irq
+        lda     IRQ_VECTOR+1
+        sta     old_irq+1
+        lda     #<frame_isr
+        sta     IRQ_VECTOR
+        lda     #>frame_isr
+        sta     IRQ_VECTOR+1
+
+        lda     #<FRAME_IRQ_LINE
+        sta     VIC_RASTER
+.ifdef FW_SPRITES
+        lda     #0
+        sta     split_line
+.endif
+        lda     VIC_CTRL1
+        and     #$7F                    ; raster bit 8 = 0
+        sta     VIC_CTRL1
+        lda     #$01
+        sta     VIC_IRR                 ; drop anything pending
+        ora     VIC_IMR
+        sta     VIC_IMR
+        cli
+        rts
+.endproc
+
+; void frame_shutdown (void);
+.proc   _frame_shutdown
+        sei
+        lda     VIC_IMR
+        and     #$FE
+        sta     VIC_IMR
+        lda     #$01
+        sta     VIC_IRR
+        lda     old_irq
+        sta     IRQ_VECTOR
+        lda     old_irq+1
+        sta     IRQ_VECTOR+1
+        cli
+        rts
+.endproc
+
+; unsigned int frame_raster (void);
+; Current 9-bit raster line.
+.proc   _frame_raster
+@retry: lda     VIC_RASTER
+        ldx     #0
+        bit     VIC_CTRL1
+        bpl     @low
+        inx
+@low:   cmp     VIC_RASTER              ; line changed between the reads?
+        bne     @retry
+        rts
+.endproc
+
+; Entered through the KERNAL vector with A, X, Y already on the stack.
+.proc   frame_isr
+        lda     VIC_IRR
+        and     #$01
+        beq     @chain
+        sta     VIC_IRR                 ; acknowledge raster IRQ
+.ifdef FW_DOUBLE
+        lda     _frame_flip
+        beq     @same
+        sta     VIC_ADDR
+        lda     #0
+        sta     _frame_flip
+@same:
+.endif
+.ifdef FW_SPRITES
+        lda     split_line
+        bne     @split
+        inc     _frame_ticks
+        jsr     snd_tick
+        jsr     in_scan
+        jsr     mux_frame
+        jmp     @arm
+@split: jsr     mux_split
+@arm:   sta     split_line
+        bne     @line
+        lda     #<FRAME_IRQ_LINE
+@line:  sta     VIC_RASTER
+.else
+        inc     _frame_ticks
+        jsr     snd_tick
+        jsr     in_scan
+.endif
+        jmp     KERNAL_IRQ_EXIT
+@chain: jmp     (old_irq)
+.endproc
@@ -0,0 +1,153 @@
+/*
+ * Headless host driver for the fireworks simulation.
+ *
+ * Builds main.c with FW_HOST, so update_simulation, spawn_explosion and
+ * launch_firework are the same code the C64 runs, drawing into
+ * host_vidram/host_colram instead of $0400/$D800; the sound driver is a
+ * silent stub. Each simulated frame is one drawn step
+ * (update_simulation(1)); launches come from a script and/or a fixed
+ * interval. After every frame the screen and colour RAM are hashed
+ * (FNV-1a), so two runs can be compared line by line.
+ *
+ * usage: fireworks_host [-n frames] [-s seed] [-a every] [-q] [script]
+ *
+ * The script lists frame numbers, one launch per line, in ascending order;
+ * '#' starts a comment. Output is "frame hash live" per frame (unless -q),
+ * then "final <hash>" covering the whole run.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host.h"
+#include "sound.h"
+
+#define MAX_LAUNCHES 1024
+
+unsigned char host_vidram[HOST_SCREEN_SIZE];
+unsigned char host_colram[HOST_SCREEN_SIZE];
+
+static unsigned long launches[MAX_LAUNCHES];
+static unsigned int launch_count;
+
+void snd_init(void) {}
+
+void snd_shutdown(void) {}
+
+void snd_play(unsigned char id) { (void)id; }
+
+static unsigned long fnv1a(unsigned long h, const unsigned char *p,
+                           size_t len) {
+  while (len--) {
+    h ^= *p++;
+    h = (h * 16777619UL) & 0xFFFFFFFFUL;
+  }
+  return h;
+}
+
+static int read_script(const char *path) {
+  FILE *f = fopen(path, "r");
+  char line[128];
+  unsigned long frame;
+
+  if (f == NULL) {
+    perror(path);
+    return -1;
+  }
+  while (fgets(line, sizeof(line), f) != NULL) {
+    if (sscanf(line, " %lu", &frame) != 1)
+      continue; /* blank or comment */
+    if (launch_count == MAX_LAUNCHES) {
+      fprintf(stderr, "%s: more than %d launches\n", path, MAX_LAUNCHES);
+      fclose(f);
+      return -1;
+    }
+    launches[launch_count++] = frame;
+  }
+  fclose(f);
+  return 0;
+}
+
+static void usage(void) {
+  fprintf(stderr,
+          "usage: fireworks_host [-n frames] [-s seed] [-a every] [-q] "
+          "[script]\n");
+}
+
+int main(int argc, char **argv) {
+  unsigned long frames = 300, every = 0, frame, h, run = 2166136261UL;
+  unsigned char hb[4];
+  unsigned int next = 0;
+  unsigned int seed = 123;
+  int quiet = 0, i;
+
+  for (i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-q") == 0) {
+      quiet = 1;
+    } else if (argv[i][0] == '-' && i + 1 < argc) {
+      unsigned long v = strtoul(argv[i + 1], NULL, 0);
+      switch (argv[i][1]) {
+      case 'n':
+        frames = v;
+        break;
+      case 's':
+        seed = (unsigned int)(v & 0xFFFF);
+        break;
+      case 'a':
+        every = v;
+        break;
+      default:
+        usage();
+        return 2;
+      }
+      ++i;
+    } else if (argv[i][0] != '-') {
+      if (read_script(argv[i]) != 0)
+        return 1;
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  if (seed == 0) {
+    fprintf(stderr, "seed must be nonzero\n"); /* xorshift fixed point */
+    return 2;
+  }
+
+  memset(host_vidram, ' ', sizeof(host_vidram));
+  memset(host_colram, 0, sizeof(host_colram));
+  init_tables();
+  snd_init();
+  init_particles();
+  rnd_init(seed);
+  init_patterns();
+
+  for (frame = 0; frame < frames; ++frame) {
+    /* The C64 tops the random pool up while it waits for the frame;
+     * assume there is always time for all of it */
+    while (rnd_refill())
+      ;
+
+    while (next < launch_count && launches[next] <= frame) {
+      launch_firework();
+      ++next;
+    }
+    if (every && frame % every == 0)
+      launch_firework();
+
+    update_simulation(1);
+
+    h = fnv1a(2166136261UL, host_vidram, sizeof(host_vidram));
+    h = fnv1a(h, host_colram, sizeof(host_colram));
+    hb[0] = (unsigned char)h;
+    hb[1] = (unsigned char)(h >> 8);
+    hb[2] = (unsigned char)(h >> 16);
+    hb[3] = (unsigned char)(h >> 24);
+    run = fnv1a(run, hb, sizeof(hb));
+    if (!quiet)
+      printf("%lu %08lx %u\n", frame, h, p_live_count);
+  }
+  printf("final %08lx\n", run);
+  return 0;
+}
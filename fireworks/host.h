@@ -0,0 +1,26 @@
+/*
+ * Host build interface: what host.c needs from the simulation in main.c
+ * when it is compiled with FW_HOST.
+ */
+
+#ifndef HOST_H
+#define HOST_H
+
+#define HOST_SCREEN_SIZE 1000
+
+/* Stand-ins for the C64 screen and colour RAM, defined in host.c */
+extern unsigned char host_vidram[HOST_SCREEN_SIZE];
+extern unsigned char host_colram[HOST_SCREEN_SIZE];
+
+/* Simulation state and entry points (main.c) */
+extern unsigned char p_live_count;
+
+void init_tables(void);
+void rnd_init(unsigned int s);
+unsigned char rnd_refill(void);
+void init_particles(void);
+void init_patterns(void);
+void launch_firework(void);
+void update_simulation(unsigned char draw);
+
+#endif /* HOST_H */
@@ -4,45 +4,100 @@
  * Optimizations:
  * 1. Zero-division math (Scale 256).
  * 2. SoA for BOTH Particles AND Rockets.
- * 3. Fast PRNG replacing rand().
+ * 3. Random bytes from a page-aligned pool that a 16-bit xorshift refills
+ *    while waiting for the frame; explosion velocities from page-aligned
+ *    pattern tables, so spawning does no division.
  * 4. Inlined plotting & Delta Drawing.
- * 5. Sound Effects (SID).
+ * 5. Sound Effects (SID), queued to an IRQ-driven driver (sound.s).
+ * 6. Free-list particle pool: O(1) spawn, update visits live particles only.
+ * 7. Raster IRQ frame clock with a fixed-timestep accumulator.
+ * 8. Optional (FW_SPRITES): rockets and fresh sparks as multiplexed
+ *    hardware sprites at pixel resolution.
+ * 9. Optional (FW_BITMAP): hires or multicolor bitmap with per-pixel XOR
+ *    plotting through row/column address tables.
+ * 10. Optional (FW_DOUBLE): double-buffered text screen flipped at vblank,
+ *    with per-buffer dirty-cell lists.
+ * 11. Optional (FW_PACKED): particles as split hi/lo position bytes and
+ *    8-bit velocities, updated through drag and gravity lookup tables.
+ * 12. Optional (FW_ASM_PARTICLES): the particle loop of the packed text
+ *    renderer in 6502 assembly (particles.s); the C loop is the reference.
+ * 13. Optional (FW_CHARSET): text mode with a generated charset of 2x2 or
+ *    4x4 sub-cell dot glyphs chosen from the position low bytes.
+ *
+ * FW_BENCH builds launch rockets on a fixed schedule and report how many
+ * particles one frame's worth of raster time can update and draw.
+ *
+ * FW_PROFILE charges CPU cycles to main loop phases (prof.c), showing
+ * each phase as a border colour band.
+ *
+ * FW_HOST compiles the simulation natively against an in-memory screen
+ * and a silent sound driver (host.c drives it); main() and the IRQ code are left out.
  */
 
+#ifndef FW_HOST
+#include <6502.h>
+#include <c64.h>
 #include <conio.h>
+#endif
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#ifdef FW_HOST
+#include "host.h"
+#else
+#include "c64screen.h"
+#include "frame.h"
+#include "input.h"
+#endif
+#include "prof.h"
+#include "sound.h"
+#ifdef FW_SPRITES
+#include "sprmux.h"
+#endif
+
+#if defined(FW_SPRITES) &&                                                     \
+    (defined(FW_BITMAP) || defined(FW_DOUBLE) || defined(FW_CHARSET))
+#error "FW_SPRITES needs the text screen in VIC bank 0"
+#endif
+#if defined(FW_BITMAP) && (defined(FW_DOUBLE) || defined(FW_CHARSET))
+#error "FW_DOUBLE and FW_CHARSET are text mode renderers"
+#endif
+#if defined(FW_DOUBLE) && defined(FW_CHARSET)
+#error "FW_CHARSET draws in place; it does not double buffer"
+#endif
+#if defined(FW_CHARSET) && FW_CHARSET != 2 && FW_CHARSET != 4
+#error "FW_CHARSET must be 2 (2x2 glyphs) or 4 (4x4 glyphs)"
+#endif
+#if defined(FW_MERGE) && (!defined(FW_CHARSET) || FW_CHARSET != 2)
+#error "FW_MERGE needs FW_CHARSET=2"
+#endif
+#if defined(FW_HOST) && (defined(FW_SPRITES) || defined(FW_BITMAP) ||         \
+                         defined(FW_DOUBLE) || defined(FW_CHARSET))
+#error "FW_HOST supports the plain text renderer only"
+#endif
+#if defined(FW_HOST) && (defined(FW_BENCH) || defined(FW_PROFILE))
+#error "FW_BENCH and FW_PROFILE measure time on the C64"
+#endif
+#if defined(FW_ASM_PARTICLES) &&                                               \
+    (!defined(FW_PACKED) || defined(FW_HOST) || defined(FW_BITMAP) ||         \
+     defined(FW_DOUBLE) || defined(FW_CHARSET))
+#error "FW_ASM_PARTICLES needs FW_PACKED and the plain text renderer"
+#endif
+
 /* Screen Memory */
+#ifdef FW_HOST
+#define VIDRAM host_vidram
+#define COLRAM host_colram
+#elif defined(FW_CHARSET)
+/* VIC bank 2, next to the charset; see charset_on */
+#define VIDRAM ((unsigned char *)0x8400)
+#define COLRAM ((unsigned char *)0xD800)
+#else
 #define VIDRAM ((unsigned char *)0x0400)
 #define COLRAM ((unsigned char *)0xD800)
-
-/* SID Registers */
-#define SID_BASE 0xD400
-typedef struct {
-  unsigned int freq1;
-  unsigned int pw1;
-  unsigned char ctrl1;
-  unsigned char ad1;
-  unsigned char sr1;
-  unsigned int freq2;
-  unsigned int pw2;
-  unsigned char ctrl2;
-  unsigned char ad2;
-  unsigned char sr2;
-  unsigned int freq3;
-  unsigned int pw3;
-  unsigned char ctrl3;
-  unsigned char ad3;
-  unsigned char sr3;
-  unsigned char filt_l;
-  unsigned char filt_h;
-  unsigned char filt_v;
-  unsigned char volume;
-} SIDPTR;
-
-#define SID_HW ((volatile SIDPTR *)SID_BASE)
+#endif
 
 /* Dimensions */
 #define SCREEN_W 40
@@ -69,23 +124,205 @@ typedef struct {
 #define TARGET_Y_RANGE (10 << SCALE)
 
 #define LIFE_MAX 30
+
+/* Fixed timestep: physics runs at SIM_HZ on both PAL (50 Hz) and NTSC
+ * (60 Hz) frame clocks. Under overload up to MAX_STEPS steps run per
+ * frame, all but the last without drawing; beyond that time is dropped. */
+#define SIM_HZ 50
+#define MAX_STEPS 3
+
+/* Cell row used to mark "not on screen" in p_sy/f_sy */
+#define NOT_DRAWN 0xFF
 #define MAX_FIREWORKS 3
-#define MAX_PARTICLES 48
+/* Pool slots are unsigned char indices: keep MAX_PARTICLES <= 255 */
+#define MAX_PARTICLES 128
+
+#ifdef FW_SPRITES
+/* Sprite blocks in the cassette buffer ($0340, $0380) */
+#define SPR_BLOCK_ROCKET 13
+#define SPR_BLOCK_SPARK 14
+#define SPR_DATA(b) ((unsigned char *)((b) * 64))
+/* Scaled units per pixel (256 per 8-pixel cell) */
+#define PIXEL_SHIFT 5
+/* Particles younger than this many steps also get a spark sprite */
+#define SPARK_STEPS 6
+#endif
+
+#if defined(FW_BITMAP) || defined(FW_DOUBLE) || defined(FW_CHARSET)
+/* Lowest address the VIC bank 2 renderers use; end of BSS must be below */
+#define BANK2_LOW 0x8400
+extern unsigned char _BSS_RUN__[], _BSS_SIZE__[];
+#endif
+
+#ifdef FW_BITMAP
+/* VIC bank 2: cell colours at $8400, bitmap at $A000 (BASIC ROM is
+ * switched out by the cc65 runtime, so it reads back as RAM). The
+ * program must end below $8400. */
+#define BITMAP ((unsigned char *)0xA000)
+#define BM_SCREEN ((unsigned char *)0x8400)
+#define BM_D018 0x18
+#define MAX_X_SCALED (SCREEN_W << SCALE)
+#define BM_DIM_COLOR 11
+#if FW_BITMAP == 2
+/* Multicolor: 160 wide, 2-bit pixels. Bright pixels use %11 (colour
+ * RAM, per cell), dim ones %01 (screen high nibble, grey everywhere). */
+#define BM_SUB_SHIFT 6
+#define BM_SUB_MASK 3
+const unsigned char bm_bright[4] = {0xC0, 0x30, 0x0C, 0x03};
+const unsigned char bm_dim[4] = {0x40, 0x10, 0x04, 0x01};
+#else
+/* Hires: 320 wide, one colour per cell from the screen high nibble */
+#define BM_SUB_SHIFT 5
+#define BM_SUB_MASK 7
+const unsigned char bm_bright[8] = {0x80, 0x40, 0x20, 0x10,
+                                    0x08, 0x04, 0x02, 0x01};
+#define bm_dim bm_bright
+#endif
+#endif
+
+#ifdef FW_DOUBLE
+/* VIC bank 2 with two screen matrices; the ROM charset shows through at
+ * $9000. Colour RAM is shared, so a cell's colour can change up to one
+ * frame before its glyph does. */
+#define SCREEN_A ((unsigned char *)0x8400)
+#define SCREEN_B ((unsigned char *)0x8800)
+#define D018_A 0x14
+#define D018_B 0x24
+/* Each object is drawn at most once per render */
+#define MAX_DIRTY (MAX_PARTICLES + MAX_FIREWORKS)
+#endif
+
+#ifdef FW_CHARSET
+/* VIC bank 2: screen at $8400, RAM charset at $8800. The charset is a
+ * copy of the ROM one with codes CS_BASE..CS_BASE+15 replaced by dot
+ * glyphs. FW_CHARSET=4 has one 2x2-pixel dot per glyph on a 4x4 grid;
+ * FW_CHARSET=2 has a 2x2 grid of dots where bit q of the code's low
+ * nibble lights quadrant q, so glyphs of one cell can be ORed together
+ * (FW_MERGE). */
+#define CS_CHARSET ((unsigned char *)0x8800)
+#define CS_D018 0x12
+#define CS_BASE 0x70
+#define CS_DIM_COLOR 11
+#endif
+
+#ifdef FW_PACKED
+/* 8-bit velocities top out at 127 (half a cell per step), so gravity is
+ * gentler and saturates there: a terminal velocity instead of the
+ * unbounded fall of the int layout */
+#define PK_GRAVITY 12
+#endif
+
+/* Explosion shapes: one page of X and one of Y velocities each */
+#define PATTERN_COUNT 4 /* power of two; keep in sync with patterns.s */
+#define PAT_RANDOM 0
+#define PAT_RING 1
+#define PAT_PALM 2
+#define PAT_WILLOW 3
 
 /* Colors */
 const unsigned char PALETTE[] = {2, 5, 6, 7, 4, 3, 8, 14};
 
 /* Helper Tables */
 unsigned int row_offsets[25];
+#ifdef FW_BITMAP
+/* Bitmap byte offset of pixel row y, and of cell column x */
+unsigned int bm_row[SCREEN_H * 8];
+unsigned int bm_col[SCREEN_W];
+#endif
+
+/* Pattern velocity tables, filled by init_patterns */
+#ifdef FW_HOST
+signed char pat_vx[PATTERN_COUNT * 256];
+signed char pat_vy[PATTERN_COUNT * 256];
+#else
+/* Page aligned, in patterns.s */
+extern signed char pat_vx[PATTERN_COUNT * 256];
+extern signed char pat_vy[PATTERN_COUNT * 256];
+#endif
+
+/* Random byte ring, refilled by rnd_refill */
+#ifdef FW_HOST
+unsigned char rnd_pool[256];
+#else
+/* Page aligned, in patterns.s */
+extern unsigned char rnd_pool[256];
+#endif
+
+#ifdef FW_PACKED
+/* Next velocity for each velocity byte: vx after drag, vy after gravity */
+#ifdef FW_HOST
+unsigned char pk_drag[256];
+unsigned char pk_fall[256];
+#else
+/* Page aligned, in patterns.s */
+extern unsigned char pk_drag[256];
+extern unsigned char pk_fall[256];
+#endif
+#endif
+
+/* sin(i * 90 / 64 degrees) * 127 for i = 0..64 */
+const unsigned char SIN_Q[65] = {
+    0,   3,   6,   9,   12,  16,  19,  22,  25,  28,  31,  34,  37,
+    40,  43,  46,  49,  51,  54,  57,  60,  63,  65,  68,  71,  73,
+    76,  78,  81,  83,  85,  88,  90,  92,  94,  96,  98,  100, 102,
+    104, 106, 107, 109, 111, 112, 113, 115, 116, 117, 118, 120, 121,
+    122, 122, 123, 124, 125, 125, 126, 126, 126, 127, 127, 127, 127};
 
 /* SoA for Particles */
-unsigned char p_active[MAX_PARTICLES];
+#ifdef FW_PACKED
+/* Positions as separate high (cell) and low (sub-cell) bytes; velocities
+ * are two's complement bytes */
+unsigned char p_x_hi[MAX_PARTICLES];
+unsigned char p_x_lo[MAX_PARTICLES];
+unsigned char p_y_hi[MAX_PARTICLES];
+unsigned char p_y_lo[MAX_PARTICLES];
+unsigned char p_vx[MAX_PARTICLES];
+unsigned char p_vy[MAX_PARTICLES];
+/* Cell, and full scaled position as int, of particle i */
+#define P_SX(i) p_x_hi[i]
+#define P_SY(i) p_y_hi[i]
+#define P_X(i) ((int)(signed char)p_x_hi[i] * 256 + p_x_lo[i])
+#define P_Y(i) ((int)(signed char)p_y_hi[i] * 256 + p_y_lo[i])
+/* Position within the cell, 0..255 */
+#define P_LX(i) p_x_lo[i]
+#define P_LY(i) p_y_lo[i]
+#else
 int p_x[MAX_PARTICLES];
 int p_y[MAX_PARTICLES];
 int p_vx[MAX_PARTICLES];
 int p_vy[MAX_PARTICLES];
+#define P_SX(i) (unsigned char)(p_x[i] >> 8)
+#define P_SY(i) (unsigned char)(p_y[i] >> 8)
+#define P_X(i) p_x[i]
+#define P_Y(i) p_y[i]
+#define P_LX(i) (unsigned char)p_x[i]
+#define P_LY(i) (unsigned char)p_y[i]
+#endif
 unsigned char p_color[MAX_PARTICLES];
 signed char p_life[MAX_PARTICLES];
+/* Cell each particle was last drawn at; lets physics-only steps move a
+ * particle without losing track of what to erase */
+unsigned char p_sx[MAX_PARTICLES];
+unsigned char p_sy[MAX_PARTICLES];
+#ifdef FW_BITMAP
+/* Bitmap byte and pixel bits last XORed in; mask 0 = not drawn */
+unsigned char *p_addr[MAX_PARTICLES];
+unsigned char p_mask[MAX_PARTICLES];
+#endif
+#ifdef FW_CHARSET
+/* Glyph last drawn at p_sx/p_sy */
+unsigned char p_code[MAX_PARTICLES];
+/* Glyph for each 4x4 sub-cell position, (y >> 6) * 4 + (x >> 6) */
+unsigned char cs_code[16];
+#endif
+
+/* Particle pool: p_free is a stack of unused slots, p_live a dense list of
+ * the slots in use. Spawning pops a slot, dying swaps the last live entry
+ * into the hole, so nothing ever scans the SoA arrays for free space. */
+unsigned char p_free[MAX_PARTICLES];
+unsigned char p_free_count;
+unsigned char p_live[MAX_PARTICLES];
+unsigned char p_live_count;
 
 /* SoA for Fireworks (Rockets) */
 /* Breaking the struct to Arrays eliminates 13x multiplication overhead per
@@ -98,46 +335,104 @@ int f_vy[MAX_FIREWORKS];
 int f_target_y[MAX_FIREWORKS];
 unsigned char f_color[MAX_FIREWORKS];
 unsigned char f_exploded[MAX_FIREWORKS];
+unsigned char f_sx[MAX_FIREWORKS];
+unsigned char f_sy[MAX_FIREWORKS];
+#ifdef FW_BITMAP
+unsigned char *f_addr[MAX_FIREWORKS];
+unsigned char f_mask[MAX_FIREWORKS];
+#endif
 
-/* Simple Fast PRNG State */
-unsigned char seed = 123;
+#ifdef FW_DOUBLE
+/* Back buffer: off screen, rendered into, shown by the next flip */
+unsigned char *back;
+unsigned char back_d018;
+unsigned char back_idx;
+/* Cells each buffer's last render wrote, cleared before its next one */
+unsigned int dirty_a[MAX_DIRTY];
+unsigned int dirty_b[MAX_DIRTY];
+unsigned char dirty_n[2];
+unsigned int *back_dirty;
+unsigned char back_n;
+unsigned char saved_d018;
+#endif
 
-/* Sound System */
-void init_sound() {
-  SID_HW->volume = 15;
-  SID_HW->ad1 = 0x09;
-  SID_HW->sr1 = 0x00;
-  SID_HW->ad3 = 0x09;
-  SID_HW->sr3 = 0x00;
-}
+/* Raster lines used by the last frame's work, from the frame IRQ on */
+unsigned int frame_budget;
 
-/* Fast 8-bit PRNG */
-unsigned char fast_rand() {
-  seed ^= seed << 2;
-  seed ^= seed >> 5;
-  seed ^= seed << 3;
-  return seed;
+#ifdef FW_BENCH
+/* Video frames per run and between automatic launches */
+#define BENCH_FRAMES 1500
+#define BENCH_LAUNCH 8
+#if defined(FW_BITMAP) && FW_BITMAP == 2
+#define BENCH_MODE "multicolor"
+#elif defined(FW_BITMAP)
+#define BENCH_MODE "hires"
+#elif defined(FW_CHARSET) && FW_CHARSET == 4
+#define BENCH_MODE "charset 4x4"
+#elif defined(FW_MERGE)
+#define BENCH_MODE "charset 2x2, merged"
+#elif defined(FW_CHARSET)
+#define BENCH_MODE "charset 2x2"
+#elif defined(FW_ASM_PARTICLES)
+#define BENCH_MODE "text, packed, asm"
+#elif defined(FW_PACKED)
+#define BENCH_MODE "text, packed"
+#else
+#define BENCH_MODE "text"
+#endif
+/* Totals over drawn frames */
+unsigned int bench_frames;
+unsigned long bench_particles;
+unsigned long bench_lines;
+/* Most live particles in a drawn frame that still fit in the frame */
+unsigned char bench_steady;
+/* Worst frame, and worst single spawn_explosion, in raster lines */
+unsigned int bench_peak;
+unsigned int bench_spawn_peak;
+unsigned int bench_frame_lines;
+#endif
+
+#define RND_SEED 123
+
+/* Random numbers. Hot paths take bytes from rnd_pool with RND(), one
+ * indexed load; the main loop replaces consumed bytes while it waits for
+ * the frame tick. While refilling keeps up, RND() returns exactly the
+ * generator's sequence. A burst of more than 256 bytes between refills
+ * reuses old ones. */
+uint16_t rnd_state; /* 16 bits on the host too, or the sequence differs */
+unsigned char rnd_head; /* next byte RND() returns */
+unsigned char rnd_fill; /* next byte to replace; == rnd_head: all fresh */
+#define RND() rnd_pool[rnd_head++]
+
+/* xorshift (7, 9, 8): period 65535 over nonzero states */
+unsigned char rnd_next() {
+  rnd_state ^= rnd_state << 7;
+  rnd_state ^= rnd_state >> 9;
+  rnd_state ^= rnd_state << 8;
+  return (unsigned char)rnd_state;
 }
 
-/* Helper for 16-bit random using fast 8-bit parts */
-unsigned int fast_rand16() {
-  return (unsigned int)fast_rand() | ((unsigned int)fast_rand() << 8);
+/* Seeds the generator (nonzero) and fills the whole pool */
+void rnd_init(unsigned int s) {
+  rnd_state = s;
+  rnd_head = 0;
+  do {
+    rnd_pool[rnd_head] = rnd_next();
+  } while (++rnd_head != 0);
+  rnd_fill = 0;
 }
 
-void sfx_launch() {
-  SID_HW->ctrl1 = 0;
-  SID_HW->freq1 = 1000 + (fast_rand() << 2);
-  SID_HW->ad1 = 0x59;
-  SID_HW->sr1 = 0x00;
-  SID_HW->ctrl1 = 17;
+/* Replaces one consumed byte; returns 0 when the pool is already fresh */
+unsigned char rnd_refill() {
+  if (rnd_fill == rnd_head)
+    return 0;
+  rnd_pool[rnd_fill++] = rnd_next();
+  return 1;
 }
 
-void sfx_explode() {
-  SID_HW->ctrl3 = 0;
-  SID_HW->freq3 = 4000;
-  SID_HW->ad3 = 0x08;
-  SID_HW->sr3 = 0x05;
-  SID_HW->ctrl3 = 129;
+unsigned int rnd16() {
+  unsigned char lo = RND();
+  return lo | ((unsigned int)RND() << 8);
 }
 
 void init_tables() {
@@ -145,130 +440,623 @@ void init_tables() {
   for (i = 0; i < SCREEN_H; ++i) {
     row_offsets[i] = i * SCREEN_W;
   }
+#ifdef FW_BITMAP
+  for (i = 0; i < SCREEN_H * 8; ++i) {
+    bm_row[i] = (i >> 3) * (SCREEN_W * 8) + (i & 7);
+  }
+  for (i = 0; i < SCREEN_W; ++i) {
+    bm_col[i] = i * 8;
+  }
+#endif
+#ifdef FW_CHARSET
+  for (i = 0; i < 16; ++i) {
+#if FW_CHARSET == 4
+    cs_code[i] = CS_BASE + i;
+#else
+    /* Quadrant (x >> 7, y >> 7) */
+    cs_code[i] = CS_BASE | (1 << (((i >> 2) & 2) | ((i >> 1) & 1)));
+#endif
+  }
+#endif
+}
+
+#ifdef FW_BITMAP
+/* Erase by XORing the same bits back out */
+#define ERASE_PARTICLE(i)                                                      \
+  if (p_mask[i]) {                                                             \
+    *p_addr[i] ^= p_mask[i];                                                   \
+  }
+#define ERASE_ROCKET(i)                                                        \
+  if (f_mask[i]) {                                                             \
+    *f_addr[i] ^= f_mask[i];                                                   \
+  }
+
+void bitmap_on() {
+  memset(BITMAP, 0, SCREEN_W * SCREEN_H * 8);
+  memset(BM_SCREEN, (BM_DIM_COLOR << 4) | BM_DIM_COLOR, SCREEN_W * SCREEN_H);
+  CIA2.pra = (CIA2.pra & 0xFC) | 0x01; /* VIC bank 2 */
+  VIC.addr = BM_D018;
+  VIC.ctrl1 |= 0x20;
+#if FW_BITMAP == 2
+  VIC.ctrl2 |= 0x10;
+#endif
+}
+
+void bitmap_off() {
+  VIC.ctrl2 &= ~0x10;
+  VIC.ctrl1 &= ~0x20;
+  VIC.addr = 0x15;
+  CIA2.pra |= 0x03; /* VIC bank 0 */
+}
+#elif defined(FW_DOUBLE)
+/* Every render starts from cleared cells, so nothing erases in place */
+#define ERASE_PARTICLE(i)
+#define ERASE_ROCKET(i)
+
+#define PLOT(off, ch, col)                                                     \
+  back[off] = (ch);                                                            \
+  COLRAM[off] = (col);                                                         \
+  back_dirty[back_n++] = (off);
+
+void select_back(unsigned char idx) {
+  back_idx = idx;
+  if (idx) {
+    back = SCREEN_B;
+    back_dirty = dirty_b;
+    back_d018 = D018_B;
+  } else {
+    back = SCREEN_A;
+    back_dirty = dirty_a;
+    back_d018 = D018_A;
+  }
+}
+
+/* Shows screen A, draws into B; both start as a copy of the text screen
+ * (blank sky plus the status line) */
+void double_on() {
+  memcpy(SCREEN_A, VIDRAM, SCREEN_W * SCREEN_H);
+  memcpy(SCREEN_B, VIDRAM, SCREEN_W * SCREEN_H);
+  dirty_n[0] = 0;
+  dirty_n[1] = 0;
+  select_back(1);
+  saved_d018 = VIC.addr;
+  VIC.addr = D018_A;
+  CIA2.pra = (CIA2.pra & 0xFC) | 0x01; /* VIC bank 2 */
+}
+
+void double_off() {
+  VIC.addr = saved_d018;
+  CIA2.pra |= 0x03; /* VIC bank 0 */
+}
+
+/* Clears what the back buffer showed two renders ago */
+void begin_draw() {
+  register unsigned char k;
+  unsigned char n = dirty_n[back_idx];
+
+  /* The last flip has not happened yet: back is still on screen */
+  while (frame_flip)
+    ;
+  for (k = 0; k < n; ++k) {
+    back[back_dirty[k]] = ' ';
+  }
+  back_n = 0;
+}
+
+/* Queues the back buffer for display at the next frame IRQ */
+void end_draw() {
+  dirty_n[back_idx] = back_n;
+  frame_flip = back_d018;
+  select_back(back_idx ^ 1);
+}
+#elif defined(FW_MERGE)
+/* Takes only this particle's dot out of a merged glyph; anything else
+ * in the cell was drawn over it and is left alone */
+void cs_erase(unsigned char *a, unsigned char code) {
+  unsigned char v = *a;
+  if ((v & 0xF0) == CS_BASE) {
+    v &= ~(code & 0x0F);
+    *a = (v == CS_BASE) ? ' ' : v;
+  }
+}
+
+#define ERASE_PARTICLE(i)                                                      \
+  if (p_sy[i] < 24) {                                                          \
+    cs_erase(VIDRAM + row_offsets[p_sy[i]] + p_sx[i], p_code[i]);              \
+  }
+#define ERASE_ROCKET(i)                                                        \
+  if (f_sy[i] < 24) {                                                          \
+    VIDRAM[row_offsets[f_sy[i]] + f_sx[i]] = ' ';                              \
+  }
+/* Adds a dot to what is in the cell, or replaces a non-dot glyph */
+#define CS_PUT(off, ch)                                                        \
+  VIDRAM[off] = ((VIDRAM[off] & 0xF0) == CS_BASE) ? (VIDRAM[off] | (ch)) : (ch);
+#define CS_MISSING(off, ch) ((VIDRAM[off] & (ch)) != (ch))
+#else
+#ifdef FW_CHARSET
+#define CS_PUT(off, ch) VIDRAM[off] = (ch);
+#define CS_MISSING(off, ch) (VIDRAM[off] != (ch))
+#endif
+#define ERASE_PARTICLE(i)                                                      \
+  if (p_sy[i] < 24) {                                                          \
+    VIDRAM[row_offsets[p_sy[i]] + p_sx[i]] = ' ';                              \
+  }
+#define ERASE_ROCKET(i)                                                        \
+  if (f_sy[i] < 24) {                                                          \
+    VIDRAM[row_offsets[f_sy[i]] + f_sx[i]] = ' ';                              \
+  }
+#endif
+
+#ifdef FW_CHARSET
+/* Builds the charset and shows it, with the text screen (status line)
+ * copied over to the bank 2 screen */
+void charset_on() {
+  register unsigned char k, r;
+  unsigned char *g;
+
+  /* Character ROM is only visible to the CPU with I/O switched out */
+  SEI();
+  *(unsigned char *)0x01 &= ~0x04;
+  memcpy(CS_CHARSET, (unsigned char *)0xD000, 256 * 8);
+  *(unsigned char *)0x01 |= 0x04;
+  CLI();
+
+  for (k = 0; k < 16; ++k) {
+    g = CS_CHARSET + (CS_BASE + k) * 8;
+    memset(g, 0, 8);
+#if FW_CHARSET == 4
+    /* Dot at column k & 3, row k >> 2 of the 4x4 grid */
+    r = (k >> 2) * 2;
+    g[r] = g[r + 1] = 0xC0 >> ((k & 3) * 2);
+#else
+    /* One centred 2x2 dot per set bit: bit 0 top left .. bit 3 bottom
+     * right */
+    for (r = 0; r < 4; ++r) {
+      if (k & (1 << r)) {
+        g[(r >> 1) * 4 + 1] |= 0x60 >> ((r & 1) * 4);
+        g[(r >> 1) * 4 + 2] |= 0x60 >> ((r & 1) * 4);
+      }
+    }
+#endif
+  }
+
+  memcpy(VIDRAM, (unsigned char *)0x0400, SCREEN_W * SCREEN_H);
+  CIA2.pra = (CIA2.pra & 0xFC) | 0x01; /* VIC bank 2 */
+  VIC.addr = CS_D018;
+}
+
+void charset_off() {
+  VIC.addr = 0x15;
+  CIA2.pra |= 0x03; /* VIC bank 0 */
+}
+#endif
+
+void init_particles() {
+  register unsigned char i;
+  for (i = 0; i < MAX_PARTICLES; ++i) {
+    p_free[i] = i;
+  }
+  p_free_count = MAX_PARTICLES;
+  p_live_count = 0;
+}
+
+/* sin of a 256-step angle, scaled by 127 */
+int sin256(unsigned char a) {
+  unsigned char q = a & 63;
+  switch (a >> 6) {
+  case 0:
+    return SIN_Q[q];
+  case 1:
+    return SIN_Q[64 - q];
+  case 2:
+    return -(int)SIN_Q[q];
+  default:
+    return -(int)SIN_Q[64 - q];
+  }
+}
+
+/* Velocity r in direction a (0..255, 64 = down, 192 = up) */
+void set_pattern(unsigned int idx, int r, unsigned char a) {
+  pat_vx[idx] = (signed char)(r * sin256(a + 64) / 128);
+  pat_vy[idx] = (signed char)(r * sin256(a) / 128);
+}
+
+/* Builds every pattern once at startup; the divisions here are the ones
+ * spawn_explosion no longer does */
+void init_patterns() {
+  register unsigned char k = 0;
+  int speed;
+
+  do {
+    /* Random: the original square spread, speed P_SPEED_MIN..MAX */
+    speed = P_SPEED_MIN + (rnd_next() % (P_SPEED_MAX - P_SPEED_MIN));
+    pat_vx[(PAT_RANDOM << 8) + k] = (rnd_next() % (speed * 2)) - speed;
+    pat_vy[(PAT_RANDOM << 8) + k] = (rnd_next() % (speed * 2)) - speed;
+
+    /* Ring: all directions at one speed, slightly jittered */
+    set_pattern((PAT_RING << 8) + k, 100 + (rnd_next() & 7), k);
+
+    /* Palm: 8 fronds fanned around straight up, speed along the frond */
+    set_pattern((PAT_PALM << 8) + k, 50 + ((k >> 3) << 1),
+                161 + (k & 7) * 9);
+
+    /* Willow: slow in all directions, so gravity bends it over. Speed
+     * first, in its own statement: argument order differs between
+     * compilers, and the host build must match. */
+    speed = 20 + (rnd_next() & 31);
+    set_pattern((PAT_WILLOW << 8) + k, speed, rnd_next());
+  } while (++k != 0);
+
+#ifdef FW_PACKED
+  do {
+    speed = (signed char)k;
+    pk_drag[k] = (unsigned char)(speed - (speed >> 4));
+    speed += PK_GRAVITY;
+    pk_fall[k] = (unsigned char)(speed > 127 ? 127 : speed);
+  } while (++k != 0);
+#endif
 }
 
 void spawn_explosion(int x, int y, unsigned char color) {
   register unsigned char i;
-  unsigned char count = 0;
-  unsigned char p_count = 10 + (fast_rand() & 7);
+  unsigned char n;
+  unsigned char p_count = 10 + (RND() & 7);
+#ifdef FW_SPAWN_MODULO
+  int speed;
+#else
+  unsigned char k;
+  unsigned int page = (unsigned int)(RND() & (PATTERN_COUNT - 1)) << 8;
+  const signed char *vx = pat_vx + page;
+  const signed char *vy = pat_vy + page;
+#endif
+#ifdef FW_BENCH
+  unsigned int start = frame_raster(), end;
+#endif
 
-  sfx_explode();
+  snd_play(SFX_EXPLODE);
 
-  for (i = 0; i < MAX_PARTICLES; ++i) {
-    if (!p_active[i]) {
-      int speed = P_SPEED_MIN + (fast_rand() % (P_SPEED_MAX - P_SPEED_MIN));
-      p_active[i] = 1;
-      p_x[i] = x;
-      p_y[i] = y;
-      p_color[i] = color;
-      p_life[i] = LIFE_MAX;
-
-      p_vx[i] = (fast_rand() % (speed * 2)) - speed;
-      p_vy[i] = (fast_rand() % (speed * 2)) - speed;
-      count++;
-      if (count >= p_count)
-        break;
-    }
+  if (p_count > p_free_count)
+    p_count = p_free_count;
+
+  for (n = 0; n < p_count; ++n) {
+    i = p_free[--p_free_count];
+    p_live[p_live_count++] = i;
+#ifdef FW_PACKED
+    p_x_hi[i] = (unsigned char)(x >> 8);
+    p_x_lo[i] = (unsigned char)x;
+    p_y_hi[i] = (unsigned char)(y >> 8);
+    p_y_lo[i] = (unsigned char)y;
+#else
+    p_x[i] = x;
+    p_y[i] = y;
+#endif
+    p_color[i] = color;
+    p_life[i] = LIFE_MAX;
+    p_sy[i] = NOT_DRAWN;
+#ifdef FW_BITMAP
+    p_mask[i] = 0;
+#endif
+
+#ifdef FW_SPAWN_MODULO
+    /* Reference path for hitch measurements: three divisions each */
+    speed = P_SPEED_MIN + (RND() % (P_SPEED_MAX - P_SPEED_MIN));
+    p_vx[i] = (RND() % (speed * 2)) - speed;
+    p_vy[i] = (RND() % (speed * 2)) - speed;
+#else
+    k = RND();
+    p_vx[i] = vx[k];
+    p_vy[i] = vy[k];
+#endif
   }
+
+#ifdef FW_BENCH
+  end = frame_raster();
+  if (end < start)
+    end += bench_frame_lines;
+  if (end - start > bench_spawn_peak)
+    bench_spawn_peak = end - start;
+#endif
 }
 
-void update_simulation() {
+/* One fixed physics step. With draw == 0 (frame-skip) objects move but
+ * the screen is only touched to erase objects that die. */
+#ifdef FW_ASM_PARTICLES
+/* Hand-written 6502 version of the particle loop in particles.s */
+void __fastcall__ particles_asm(unsigned char draw);
+#endif
+
+void update_simulation(unsigned char draw) {
   register unsigned char i;
+#if !defined(FW_ASM_PARTICLES) || !defined(FW_SPRITES)
   register unsigned char sx, sy;
-  register unsigned char old_sx, old_sy;
   unsigned int off;
+#endif
+#ifndef FW_ASM_PARTICLES
+  unsigned char j;
+#ifdef FW_PACKED
+  unsigned char v, lo;
+#endif
+#ifdef FW_BITMAP
+  unsigned char *a;
+  unsigned char m;
+#elif !defined(FW_DOUBLE)
   unsigned char ch;
+#endif
+#endif
 
   /* FIREWORKS (SoA Optimized) */
+  PROF(PROF_ROCKETS);
   for (i = 0; i < MAX_FIREWORKS; ++i) {
     if (f_active[i] && !f_exploded[i]) {
-      old_sx = (unsigned char)(f_x[i] >> 8);
-      old_sy = (unsigned char)(f_y[i] >> 8);
-
       f_y[i] += f_vy[i];
 
       if (f_y[i] <= f_target_y[i]) {
         /* Explode */
         /* Erase old */
-        if (old_sy < 24 && old_sx < SCREEN_W) {
-          off = row_offsets[old_sy] + old_sx;
-          VIDRAM[off] = ' ';
-        }
+        ERASE_ROCKET(i)
         f_exploded[i] = 1;
         spawn_explosion(f_x[i], f_y[i], f_color[i]);
         f_active[i] = 0;
-      } else {
+      }
+#ifdef FW_BITMAP
+      else if (draw) {
+        /* One white pixel, replotted only when it moves */
+        sy = (unsigned char)((unsigned int)f_y[i] >> 5);
+        off = (unsigned int)f_x[i] >> BM_SUB_SHIFT;
+        sx = (unsigned char)(f_x[i] >> 8);
+        a = BITMAP + bm_row[sy] + bm_col[sx];
+        m = bm_bright[(unsigned char)off & BM_SUB_MASK];
+        if (a != f_addr[i] || m != f_mask[i]) {
+          ERASE_ROCKET(i)
+          *a ^= m;
+          f_addr[i] = a;
+          f_mask[i] = m;
+          off = row_offsets[sy >> 3] + sx;
+#if FW_BITMAP == 2
+          COLRAM[off] = 1;
+#else
+          BM_SCREEN[off] = 1 << 4;
+#endif
+        }
+      }
+#elif defined(FW_DOUBLE)
+      else if (draw) {
+        sx = (unsigned char)(f_x[i] >> 8);
+        sy = (unsigned char)(f_y[i] >> 8);
+        if (sy < 24 && sx < SCREEN_W) {
+          off = row_offsets[sy] + sx;
+          PLOT(off, '^', 1)
+        }
+      }
+#elif !defined(FW_SPRITES)
+      else if (draw) {
         /* Update */
         sx = (unsigned char)(f_x[i] >> 8);
         sy = (unsigned char)(f_y[i] >> 8);
 
         /* Delta Erase/Draw */
-        if (sx != old_sx || sy != old_sy) {
-          if (old_sy < 24 && old_sx < SCREEN_W) {
-            VIDRAM[row_offsets[old_sy] + old_sx] = ' ';
+        if (sx != f_sx[i] || sy != f_sy[i]) {
+          if (f_sy[i] < 24) {
+            VIDRAM[row_offsets[f_sy[i]] + f_sx[i]] = ' ';
           }
           if (sy < 24 && sx < SCREEN_W) {
             off = row_offsets[sy] + sx;
             VIDRAM[off] = '^';
             COLRAM[off] = 1; /* White */
+            f_sx[i] = sx;
+            f_sy[i] = sy;
+          } else {
+            f_sy[i] = NOT_DRAWN;
           }
         }
       }
+#endif
     }
   }
 
-  /* PARTICLES (SoA) */
-  for (i = 0; i < MAX_PARTICLES; ++i) {
-    if (p_active[i]) {
-      old_sx = (unsigned char)(p_x[i] >> 8);
-      old_sy = (unsigned char)(p_y[i] >> 8);
-
-      p_vy[i] += GRAVITY;
-      p_x[i] += p_vx[i];
-      p_y[i] += p_vy[i];
-      p_vx[i] -= (p_vx[i] >> 4);
-      p_life[i]--;
-
-      if (p_y[i] > MAX_Y_SCALED)
-        p_life[i] = 0;
-
-      if (p_life[i] <= 0) {
-        p_active[i] = 0;
-        /* Erase last position */
-        if (old_sy < 24 && old_sx < SCREEN_W) {
-          VIDRAM[row_offsets[old_sy] + old_sx] = ' ';
-        }
-      } else {
-        sx = (unsigned char)(p_x[i] >> 8);
-        sy = (unsigned char)(p_y[i] >> 8);
-        ch = (p_life[i] < 10) ? '.' : '*';
+  /* PARTICLES (SoA, live list only) */
+  PROF(draw ? PROF_PARTICLES : PROF_PHYSICS);
+#ifdef FW_ASM_PARTICLES
+  particles_asm(draw);
+#else
+  j = 0;
+  while (j < p_live_count) {
+    i = p_live[j];
 
-        /* Delta Draw */
-        if (sy < 24 && sx < SCREEN_W) {
-          off = row_offsets[sy] + sx;
+#ifdef FW_PACKED
+    /* 16-bit position += sign-extended 8-bit velocity, one byte at a
+     * time: the high byte takes the carry, minus one if v is negative */
+    v = pk_fall[p_vy[i]];
+    p_vy[i] = v;
+    lo = p_y_lo[i] + v;
+    p_y_hi[i] += (lo < v) - (v >> 7);
+    p_y_lo[i] = lo;
 
-          if (sx != old_sx || sy != old_sy) {
-            /* Erase Old */
-            if (old_sy < 24 && old_sx < SCREEN_W) {
-              VIDRAM[row_offsets[old_sy] + old_sx] = ' ';
-            }
-            /* Draw New */
-            VIDRAM[off] = ch;
-            COLRAM[off] = p_color[i];
-          } else {
-            /* Refresh char only if needed */
-            if (VIDRAM[off] != ch) {
-              VIDRAM[off] = ch;
-            }
-          }
-        } else if (old_sy < 24 && old_sx < SCREEN_W) {
-          /* Moved off screen, erase */
-          VIDRAM[row_offsets[old_sy] + old_sx] = ' ';
+    v = p_vx[i];
+    lo = p_x_lo[i] + v;
+    p_x_hi[i] += (lo < v) - (v >> 7);
+    p_x_lo[i] = lo;
+    p_vx[i] = pk_drag[v];
+    p_life[i]--;
+
+    /* Below the bottom row; rows 0x80 and up are above the top */
+    if (p_y_hi[i] >= SCREEN_H && p_y_hi[i] < 0x80)
+      p_life[i] = 0;
+#else
+    p_vy[i] += GRAVITY;
+    p_x[i] += p_vx[i];
+    p_y[i] += p_vy[i];
+    p_vx[i] -= (p_vx[i] >> 4);
+    p_life[i]--;
+
+    if (p_y[i] > MAX_Y_SCALED)
+      p_life[i] = 0;
+#endif
+
+    if (p_life[i] <= 0) {
+      /* Erase last position */
+      ERASE_PARTICLE(i)
+      /* Back to the pool; the last live slot moves into entry j */
+      p_free[p_free_count++] = i;
+      p_live[j] = p_live[--p_live_count];
+      continue;
+    }
+    ++j;
+
+    if (!draw)
+      continue;
+
+#ifdef FW_BITMAP
+    if ((unsigned int)P_Y(i) < MAX_Y_SCALED &&
+        (unsigned int)P_X(i) < MAX_X_SCALED) {
+      sy = (unsigned char)((unsigned int)P_Y(i) >> 5);
+      sx = P_SX(i);
+      off = (unsigned int)P_X(i) >> BM_SUB_SHIFT;
+      a = BITMAP + bm_row[sy] + bm_col[sx];
+      m = (p_life[i] < 10) ? bm_dim[(unsigned char)off & BM_SUB_MASK]
+                           : bm_bright[(unsigned char)off & BM_SUB_MASK];
+      if (a != p_addr[i] || m != p_mask[i]) {
+        ERASE_PARTICLE(i)
+        *a ^= m;
+        p_addr[i] = a;
+        p_mask[i] = m;
+        off = row_offsets[sy >> 3] + sx;
+#if FW_BITMAP == 2
+        COLRAM[off] = p_color[i];
+#else
+        BM_SCREEN[off] = (p_life[i] < 10) ? (BM_DIM_COLOR << 4)
+                                          : (p_color[i] << 4);
+#endif
+      }
+    } else if (p_mask[i]) {
+      ERASE_PARTICLE(i)
+      p_mask[i] = 0;
+    }
+#elif defined(FW_DOUBLE)
+    sx = P_SX(i);
+    sy = P_SY(i);
+    if (sy < 24 && sx < SCREEN_W) {
+      off = row_offsets[sy] + sx;
+      PLOT(off, (p_life[i] < 10) ? '.' : '*', p_color[i])
+    }
+#elif defined(FW_CHARSET)
+    sx = P_SX(i);
+    sy = P_SY(i);
+    ch = cs_code[((P_LY(i) >> 4) & 0x0C) | (P_LX(i) >> 6)];
+
+    /* Delta Draw: a new cell or a new dot within the cell */
+    if (sy < 24 && sx < SCREEN_W) {
+      off = row_offsets[sy] + sx;
+
+      if (sx != p_sx[i] || sy != p_sy[i] || ch != p_code[i]) {
+        ERASE_PARTICLE(i)
+        CS_PUT(off, ch)
+        COLRAM[off] = (p_life[i] < 10) ? CS_DIM_COLOR : p_color[i];
+        p_sx[i] = sx;
+        p_sy[i] = sy;
+        p_code[i] = ch;
+      } else if (CS_MISSING(off, ch)) {
+        /* Wiped by another object sharing the cell */
+        CS_PUT(off, ch)
+      }
+    } else if (p_sy[i] < 24) {
+      ERASE_PARTICLE(i)
+      p_sy[i] = NOT_DRAWN;
+    }
+#else
+    sx = P_SX(i);
+    sy = P_SY(i);
+    ch = (p_life[i] < 10) ? '.' : '*';
+
+    /* Delta Draw */
+    if (sy < 24 && sx < SCREEN_W) {
+      off = row_offsets[sy] + sx;
+
+      if (sx != p_sx[i] || sy != p_sy[i]) {
+        /* Erase Old */
+        if (p_sy[i] < 24) {
+          VIDRAM[row_offsets[p_sy[i]] + p_sx[i]] = ' ';
+        }
+        /* Draw New */
+        VIDRAM[off] = ch;
+        COLRAM[off] = p_color[i];
+        p_sx[i] = sx;
+        p_sy[i] = sy;
+      } else {
+        /* Refresh char only if needed */
+        if (VIDRAM[off] != ch) {
+          VIDRAM[off] = ch;
         }
       }
+    } else if (p_sy[i] < 24) {
+      /* Moved off screen, erase */
+      VIDRAM[row_offsets[p_sy[i]] + p_sx[i]] = ' ';
+      p_sy[i] = NOT_DRAWN;
+    }
+#endif
+  }
+#endif /* FW_ASM_PARTICLES */
+}
+
+#ifdef FW_SPRITES
+void init_sprites() {
+  register unsigned char k;
+  unsigned char *rocket = SPR_DATA(SPR_BLOCK_ROCKET);
+  unsigned char *spark = SPR_DATA(SPR_BLOCK_SPARK);
+
+  /* Top-left pixels only, so the sprite origin is the object position:
+   * a 2x6 streak for rockets, a 2x2 dot for sparks */
+  memset(rocket, 0, 64);
+  memset(spark, 0, 64);
+  for (k = 0; k < 6; ++k) {
+    rocket[k * 3] = 0xC0;
+  }
+  spark[0] = 0xC0;
+  spark[3] = 0xC0;
+
+  mux_init();
+}
+
+/* Adds one virtual sprite at scaled world position (x, y) */
+void add_sprite(int x, int y, unsigned char block, unsigned char color) {
+  register unsigned char n = mux_count;
+  unsigned int px = MUX_X_ORIGIN + ((unsigned int)x >> PIXEL_SHIFT);
+
+  mux_x_lo[n] = (unsigned char)px;
+  mux_x_hi[n] = (unsigned char)(px >> 8);
+  mux_y[n] = MUX_Y_ORIGIN + (unsigned char)((unsigned int)y >> PIXEL_SHIFT);
+  mux_color[n] = color;
+  mux_ptr[n] = block;
+  mux_count = n + 1;
+}
+
+/* Rebuilds the sprite list: every rocket in flight, then the youngest
+ * particles as white sparks on top of their text cells while slots last */
+void update_sprites() {
+  register unsigned char i;
+#ifdef FW_SPARKS
+  unsigned char j;
+#endif
+
+  mux_count = 0;
+  for (i = 0; i < MAX_FIREWORKS; ++i) {
+    if (f_active[i] && f_y[i] >= 0 && f_y[i] < MAX_Y_SCALED) {
+      add_sprite(f_x[i], f_y[i], SPR_BLOCK_ROCKET, f_color[i]);
+    }
+  }
+#ifdef FW_SPARKS
+  for (j = 0; j < p_live_count && mux_count < MUX_MAX; ++j) {
+    i = p_live[j];
+    if (p_life[i] > LIFE_MAX - SPARK_STEPS && P_Y(i) >= 0 &&
+        P_Y(i) < MAX_Y_SCALED && P_X(i) >= 0 &&
+        P_X(i) < (SCREEN_W << SCALE)) {
+      add_sprite(P_X(i), P_Y(i), SPR_BLOCK_SPARK, 1);
     }
   }
+#endif
+  mux_commit();
 }
+#endif
 
 void launch_firework() {
   register unsigned char i;
@@ -276,51 +1064,230 @@ void launch_firework() {
     if (!f_active[i]) {
       f_active[i] = 1;
       /* Launch X: LAUNCH_X_MIN + random */
-      f_x[i] = LAUNCH_X_MIN + (fast_rand16() % LAUNCH_X_RANGE);
+      f_x[i] = LAUNCH_X_MIN + (rnd16() % LAUNCH_X_RANGE);
       f_y[i] = MAX_Y_SCALED - 256;
 
       /* Target Y: */
-      f_target_y[i] = TARGET_Y_MIN + (fast_rand16() % TARGET_Y_RANGE);
+      f_target_y[i] = TARGET_Y_MIN + (rnd16() % TARGET_Y_RANGE);
 
       f_vx[i] = 0;
       f_vy[i] = ROCKET_VY;
-      f_color[i] = PALETTE[fast_rand() & 7];
+      f_color[i] = PALETTE[RND() & 7];
       f_exploded[i] = 0;
-      sfx_launch();
+      f_sy[i] = NOT_DRAWN;
+#ifdef FW_BITMAP
+      f_mask[i] = 0;
+#endif
+      snd_play(SFX_LAUNCH);
       break;
     }
   }
 }
 
+/* Raster lines from the frame IRQ to now, counting whole frames that
+ * have passed since tick `start`. */
+#ifndef FW_HOST
+unsigned int lines_since(unsigned char start, unsigned int lines_per_frame) {
+  unsigned char t;
+  unsigned int line;
+
+  do {
+    t = frame_ticks;
+    line = frame_raster();
+  } while (t != frame_ticks);
+
+  /* Before the IRQ line: the last tick was in the previous video frame */
+  if (line < FRAME_IRQ_LINE)
+    line += lines_per_frame;
+  return (unsigned char)(t - start) * lines_per_frame + (line - FRAME_IRQ_LINE);
+}
+
+#ifdef SHOW_BUDGET
+/* Raster lines used per frame, bottom right of the status line */
+void show_budget() {
+  unsigned int v = frame_budget;
+  register unsigned char k;
+  for (k = SCREEN_W - 1; k >= SCREEN_W - 4; --k) {
+#ifdef FW_DOUBLE
+    SCREEN_A[24 * SCREEN_W + k] = '0' + (v % 10);
+    SCREEN_B[24 * SCREEN_W + k] = '0' + (v % 10);
+#else
+    VIDRAM[24 * SCREEN_W + k] = '0' + (v % 10);
+#endif
+    v /= 10;
+  }
+}
+#endif
+
+/* Status line, converted to screen codes by the compiler */
+#include <cbm_screen_charmap.h>
+const char status_text[] = "SPACE:Launch Q:Quit";
+#include <cbm_petscii_charmap.h>
+
 int main() {
-  clrscr();
-  bgcolor(0);
-  bordercolor(0);
+  unsigned char frame_hz, now, last, steps, c;
+  unsigned int lines_per_frame, acc = 0;
+#ifdef FW_BENCH
+  unsigned int ticks = 0;
+#endif
+
+#if defined(FW_BITMAP) || defined(FW_DOUBLE) || defined(FW_CHARSET)
+  if ((unsigned int)_BSS_RUN__ + (unsigned int)_BSS_SIZE__ > BANK2_LOW) {
+    cprintf("Program overlaps VIC bank 2 memory\r\n");
+    return 1;
+  }
+#endif
+
+  scr_fill(SCR_SPACE, 15);
+  VIC.bgcolor0 = 0;
+  VIC.bordercolor = 0;
   init_tables();
-  init_sound();
+  snd_init();
 
   memset(f_active, 0, sizeof(f_active));
-  memset(p_active, 0, sizeof(p_active));
+  init_particles();
+  rnd_init(RND_SEED);
+  init_patterns();
 
-  gotoxy(0, 24);
-  textcolor(15);
-  cprintf("SPACE:Launch Q:Quit");
+  scr_puts(0, 24, 15, status_text);
+
+  if (get_tv() == TV_NTSC) {
+    frame_hz = 60;
+    lines_per_frame = 263;
+  } else {
+    frame_hz = 50;
+    lines_per_frame = 312;
+  }
+#ifdef FW_BENCH
+  bench_frame_lines = lines_per_frame;
+#endif
+
+#ifdef FW_SPRITES
+  init_sprites();
+#endif
+#ifdef FW_BITMAP
+  bitmap_on();
+#endif
+#ifdef FW_DOUBLE
+  double_on();
+#endif
+#ifdef FW_CHARSET
+  charset_on();
+#endif
+  in_init();
+  frame_init();
+#ifdef FW_PROFILE
+  prof_init();
+#endif
+  last = frame_ticks;
 
   while (1) {
-    if (kbhit()) {
-      char c = cgetc();
-      if (c == ' ')
-        launch_firework();
-      if (c == 'q')
-        break;
+    /* One queued event per frame; the IRQ keeps scanning meanwhile */
+    PROF(PROF_INPUT);
+    c = in_get();
+    if (c == IN_KEY_SPACE || c == IN_JOY2 + IN_JOY_FIRE)
+      launch_firework();
+    if (c == IN_KEY_Q || c == IN_KEY_STOP)
+      break;
+
+    /* Sleep until the next frame, topping up the random pool meanwhile,
+     * then bank the elapsed time */
+    PROF(PROF_IDLE);
+    while ((now = frame_ticks) == last)
+      rnd_refill();
+    PROF_FRAME();
+    acc += (unsigned char)(now - last) * SIM_HZ;
+#ifdef FW_BENCH
+    ticks += (unsigned char)(now - last);
+    if (ticks >= BENCH_FRAMES)
+      break;
+    if ((now & (BENCH_LAUNCH - 1)) == 0)
+      launch_firework();
+#endif
+    last = now;
+
+    steps = 0;
+    while (acc >= frame_hz && steps < MAX_STEPS) {
+      acc -= frame_hz;
+      ++steps;
+    }
+    if (acc >= frame_hz) {
+      acc = 0; /* Overloaded: drop the backlog rather than spiral */
+    }
+
+    while (steps > 1) {
+      update_simulation(0);
+      --steps;
+    }
+    if (steps) {
+#ifdef FW_DOUBLE
+      PROF(PROF_PRESENT);
+      begin_draw();
+      update_simulation(1);
+      PROF(PROF_PRESENT);
+      end_draw();
+#else
+      update_simulation(1);
+      PROF(PROF_PRESENT);
+#endif
+#ifdef FW_SPRITES
+      update_sprites();
+#endif
     }
-    update_simulation();
+
+    frame_budget = lines_since(now, lines_per_frame);
+#ifdef FW_BENCH
+    if (steps) {
+      ++bench_frames;
+      bench_particles += p_live_count;
+      bench_lines += frame_budget;
+      if (frame_budget > bench_peak)
+        bench_peak = frame_budget;
+      if (frame_budget < lines_per_frame && p_live_count > bench_steady)
+        bench_steady = p_live_count;
+    }
+#endif
+#ifdef SHOW_BUDGET
+    show_budget();
+#endif
   }
 
-  SID_HW->volume = 0;
-  SID_HW->ctrl1 = 0;
-  SID_HW->ctrl3 = 0;
+  frame_shutdown();
+  in_stop();
+#ifdef FW_SPRITES
+  mux_shutdown();
+#endif
+#ifdef FW_BITMAP
+  bitmap_off();
+#endif
+#ifdef FW_DOUBLE
+  double_off();
+#endif
+#ifdef FW_CHARSET
+  charset_off();
+#endif
+
+  snd_shutdown();
 
   clrscr();
+#ifdef FW_PROFILE
+  bordercolor(0);
+  cprintf("Writing prof.csv... %s\r\n", prof_dump() ? "failed" : "ok");
+#endif
+#ifdef FW_BENCH
+  /* Particles per frame: live particles per drawn frame scaled by how
+   * much of a video frame that work took */
+  textcolor(1);
+  cprintf("mode %s, %u drawn frames\r\n", BENCH_MODE, bench_frames);
+  if (bench_frames && bench_lines) {
+    cprintf("avg particles %lu, avg lines %lu\r\n",
+            bench_particles / bench_frames, bench_lines / bench_frames);
+    cprintf("particles/frame %lu, steady max %u\r\n",
+            bench_particles * lines_per_frame / bench_lines, bench_steady);
+  }
+  /* The hitch: worst frame and the explosion spawn inside it */
+  cprintf("peak lines %u, spawn peak %u\r\n", bench_peak, bench_spawn_peak);
+#endif
   return 0;
 }
+#endif /* FW_HOST */
@@ -0,0 +1,193 @@
+;
+; 6502 particle update and text-mode draw kernel (FW_ASM_PARTICLES).
+;
+; Drop-in for the particle loop of update_simulation in main.c with the
+; packed layout (FW_PACKED) and the plain text renderer; it reads and
+; writes the same SoA arrays and pool lists, step for step like the C
+; loop. Particle index lives in X for all array access. Screen rows come
+; from scr_row_lo/scr_row_hi, c64screen.s's row address tables; the row
+; address is patched into the operands of the glyph and colour stores,
+; which then index the column with Y.
+;
+
+        .export         _particles_asm
+
+        .import         _p_x_hi, _p_x_lo, _p_y_hi, _p_y_lo
+        .import         _p_vx, _p_vy, _p_color, _p_life, _p_sx, _p_sy
+        .import         _p_live, _p_live_count, _p_free, _p_free_count
+        .import         _pk_drag, _pk_fall
+        .import         _scr_row_lo, _scr_row_hi
+
+VIDRAM          = $0400                 ; the screen c64screen.s addresses
+COLRAM          = $D800
+SCREEN_W        = 40
+SCREEN_H        = 25
+DRAW_ROWS       = 24                    ; row 24 is the status line
+NOT_DRAWN       = $FF
+LIFE_DIM        = 10                    ; '.' below this, '*' from here
+
+GLYPH_SPACE     = $20
+GLYPH_BRIGHT    = $2A                   ; '*'
+GLYPH_DIM       = $2E                   ; '.'
+
+.segment        "BSS"
+
+draw:           .res    1
+live_j:         .res    1               ; index into p_live
+glyph:          .res    1
+
+.segment        "CODE"
+
+; Blanks the cell particle X was last drawn at, if any. Returns with C
+; set when there was none.
+.proc   erase_old
+        ldy     _p_sy,x
+        cpy     #DRAW_ROWS
+        bcs     @done
+        lda     _scr_row_lo,y
+        sta     @store+1
+        lda     _scr_row_hi,y
+        sta     @store+2
+        ldy     _p_sx,x
+        lda     #GLYPH_SPACE
+@store: sta     $FFFF,y
+@done:  rts
+.endproc
+
+; void __fastcall__ particles_asm (unsigned char draw);
+.proc   _particles_asm
+        sta     draw
+        lda     #0
+        sta     live_j
+
+next:   ldy     live_j
+        cpy     _p_live_count
+        bcc     @body
+        rts
+@body:  ldx     _p_live,y
+
+        ; vy = fall[vy]; y += vy
+        ldy     _p_vy,x
+        lda     _pk_fall,y
+        sta     _p_vy,x
+        bmi     @yneg
+        clc
+        adc     _p_y_lo,x
+        sta     _p_y_lo,x
+        bcc     @ydone
+        inc     _p_y_hi,x
+        bcs     @ydone                  ; always
+@yneg:  clc
+        adc     _p_y_lo,x
+        sta     _p_y_lo,x
+        bcs     @ydone                  ; carry cancels the sign
+        dec     _p_y_hi,x
+@ydone:
+
+        ; x += vx; vx = drag[vx]
+        ldy     _p_vx,x
+        tya
+        bmi     @xneg
+        clc
+        adc     _p_x_lo,x
+        sta     _p_x_lo,x
+        bcc     @xdone
+        inc     _p_x_hi,x
+        bcs     @xdone                  ; always
+@xneg:  clc
+        adc     _p_x_lo,x
+        sta     _p_x_lo,x
+        bcs     @xdone
+        dec     _p_x_hi,x
+@xdone: lda     _pk_drag,y
+        sta     _p_vx,x
+
+        ; Age; fell below the bottom row (0x80 and up is above the top)
+        dec     _p_life,x
+        lda     _p_y_hi,x
+        cmp     #SCREEN_H
+        bcc     @aged
+        cmp     #$80
+        bcs     @aged
+        lda     #0
+        sta     _p_life,x
+@aged:  lda     _p_life,x
+        beq     @dies
+        bpl     @lives
+
+        ; Dead: erase, return the slot, move the last live entry here
+@dies:  jsr     erase_old
+        txa
+        ldy     _p_free_count
+        sta     _p_free,y
+        inc     _p_free_count
+        dec     _p_live_count
+        ldy     _p_live_count
+        lda     _p_live,y
+        ldy     live_j
+        sta     _p_live,y
+        jmp     next
+
+@lives: inc     live_j
+        lda     draw
+        bne     plot
+        jmp     next
+
+plot:   ldy     #GLYPH_BRIGHT
+        lda     _p_life,x
+        cmp     #LIFE_DIM
+        bcs     @bright
+        ldy     #GLYPH_DIM
+@bright:
+        sty     glyph
+
+        lda     _p_y_hi,x
+        cmp     #DRAW_ROWS
+        bcs     @off
+        ldy     _p_x_hi,x
+        cpy     #SCREEN_W
+        bcs     @off
+
+        tay                             ; patch the row into the stores
+        lda     _scr_row_lo,y
+        sta     @read+1
+        sta     @glyph+1
+        sta     @color+1
+        lda     _scr_row_hi,y
+        sta     @read+2
+        sta     @glyph+2
+        clc
+        adc     #>(COLRAM - VIDRAM)
+        sta     @color+2
+
+        lda     _p_x_hi,x
+        cmp     _p_sx,x
+        bne     @moved
+        lda     _p_y_hi,x
+        cmp     _p_sy,x
+        bne     @moved
+
+        ldy     _p_x_hi,x               ; same cell: rewrite a changed glyph
+        lda     glyph
+@read:  cmp     $FFFF,y
+        bne     @glyph
+        jmp     next
+
+@moved: jsr     erase_old
+        lda     _p_x_hi,x
+        sta     _p_sx,x
+        tay
+        lda     _p_y_hi,x
+        sta     _p_sy,x
+        lda     _p_color,x
+@color: sta     $FFFF,y
+        lda     glyph
+@glyph: sta     $FFFF,y
+        jmp     next
+
+@off:   jsr     erase_old               ; left the screen
+        bcs     @gone
+        lda     #NOT_DRAWN
+        sta     _p_sy,x
+@gone:  jmp     next
+.endproc
@@ -0,0 +1,29 @@
+;
+; Page-aligned storage for the velocity tables that init_patterns (main.c)
+; fills at startup. Each explosion pattern owns one page of X and one page
+; of Y velocities, so spawn_explosion reads them through a pointer whose
+; low byte is zero and a random byte as index: (ptr),Y never crosses a
+; page. FW_PACKED builds add the per-velocity drag and gravity tables.
+; rnd_pool is the random byte ring: RND() in main.c reads it with an
+; 8-bit index that wraps by itself.
+;
+
+        .export         _pat_vx, _pat_vy, _rnd_pool
+
+PATTERN_COUNT   = 4                     ; keep in sync with main.c
+
+.segment        "BSS"
+
+        .align  256
+_pat_vx:        .res    PATTERN_COUNT * 256
+_pat_vy:        .res    PATTERN_COUNT * 256
+_rnd_pool:      .res    256
+
+.ifdef FW_PACKED
+; Packed particle layout: next vx after drag and next vy after gravity,
+; indexed by the current velocity byte
+        .export         _pk_drag, _pk_fall
+        .align  256
+_pk_drag:       .res    256
+_pk_fall:       .res    256
+.endif
@@ -0,0 +1,91 @@
+/*
+ * Phase profiler for the fireworks main loop (see prof.h).
+ *
+ * CIA2 timer A free-runs from $FFFF in continuous mode, one count per
+ * system clock, so the cycles between two marks are the difference of
+ * two reads modulo 65536. That caps a single phase at 65535 cycles,
+ * over three PAL frames. IRQ handlers (frame clock, keyboard scan) are
+ * charged to whichever phase they interrupt.
+ */
+
+#include <c64.h>
+#include <cbm.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "prof.h"
+
+#define PROF_DEV 8
+#define PROF_LFN 2
+
+static const unsigned char PROF_COLORS[PROF_PHASES] = {0, 2, 7, 5, 6, 4};
+
+struct prof_ring prof_ring = {{0x46, 0x57, 0x50, 0x52}, PROF_PHASES, 0};
+
+static unsigned int acc[PROF_PHASES];
+static unsigned int last;
+static unsigned char current;
+
+static unsigned int timer_read(void) {
+  unsigned char hi, lo;
+  do {
+    hi = CIA2.ta_hi;
+    lo = CIA2.ta_lo;
+  } while (hi != CIA2.ta_hi);
+  return ((unsigned int)hi << 8) | lo;
+}
+
+void prof_init(void) {
+  CIA2.cra = 0x00;
+  CIA2.ta_lo = 0xff;
+  CIA2.ta_hi = 0xff;
+  CIA2.cra = 0x11; /* force load, count phi2, continuous, start */
+  memset(acc, 0, sizeof(acc));
+  current = PROF_IDLE;
+  last = timer_read();
+}
+
+void prof_phase(unsigned char phase) {
+  unsigned int now = timer_read();
+
+  acc[current] += last - now; /* the timer counts down */
+  last = now;
+  current = phase;
+  VIC.bordercolor = PROF_COLORS[phase];
+}
+
+void prof_frame(void) {
+  register unsigned char k;
+  unsigned int *slot = prof_ring.cycles[prof_ring.next];
+
+  prof_phase(current);
+  for (k = 0; k < PROF_PHASES; ++k) {
+    slot[k] = acc[k];
+    acc[k] = 0;
+  }
+  if (++prof_ring.next == PROF_FRAMES)
+    prof_ring.next = 0;
+}
+
+unsigned char prof_dump(void) {
+  static char line[48];
+  unsigned char f, k, slot, n;
+
+  if (cbm_open(PROF_LFN, PROF_DEV, 2, "prof.csv,s,w") != 0) {
+    return 1;
+  }
+  /* Oldest frame first */
+  slot = prof_ring.next;
+  for (f = 0; f < PROF_FRAMES; ++f) {
+    n = 0;
+    for (k = 0; k < PROF_PHASES; ++k) {
+      n += sprintf(line + n, k ? ",%u" : "%u", prof_ring.cycles[slot][k]);
+    }
+    line[n++] = '\n';
+    cbm_write(PROF_LFN, line, n);
+    if (++slot == PROF_FRAMES)
+      slot = 0;
+  }
+  cbm_close(PROF_LFN);
+  return 0;
+}
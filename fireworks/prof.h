@@ -0,0 +1,50 @@
+/*
+ * Per-frame phase profiler (prof.c), compiled in with FW_PROFILE.
+ *
+ * PROF(phase) marks the start of a phase: the cycles since the previous
+ * mark are charged to the phase that was running, and the border changes
+ * to the new phase's colour so the split is visible as raster bars.
+ * Without FW_PROFILE every PROF_* macro expands to nothing.
+ */
+
+#ifndef PROF_H
+#define PROF_H
+
+/* Phases and their border colours */
+#define PROF_IDLE 0      /* black: waiting for the frame tick */
+#define PROF_INPUT 1     /* red: keyboard polling */
+#define PROF_ROCKETS 2   /* yellow: rocket update and explosion spawns */
+#define PROF_PARTICLES 3 /* green: particle physics and drawing */
+#define PROF_PHYSICS 4   /* blue: particle physics in catch-up steps */
+#define PROF_PRESENT 5   /* purple: sprites, buffer flips, status line */
+#define PROF_PHASES 6
+
+/* Frames kept in the ring */
+#define PROF_FRAMES 64
+
+#ifdef FW_PROFILE
+/* Ring of per-frame phase totals in CPU cycles. Find it in a memory dump
+ * by the ASCII magic "FWPR", or by the _prof_ring label in VICE. */
+struct prof_ring {
+  unsigned char magic[4];
+  unsigned char phases;
+  unsigned char next; /* slot the next finished frame goes to */
+  unsigned int cycles[PROF_FRAMES][PROF_PHASES];
+};
+extern struct prof_ring prof_ring;
+
+void prof_init(void);
+void prof_phase(unsigned char phase);
+/* Closes the current frame's totals into the ring */
+void prof_frame(void);
+/* Writes the ring to "prof.csv" on device 8; returns 0 on success */
+unsigned char prof_dump(void);
+
+#define PROF(phase) prof_phase(phase)
+#define PROF_FRAME() prof_frame()
+#else
+#define PROF(phase)
+#define PROF_FRAME()
+#endif
+
+#endif /* PROF_H */
@@ -0,0 +1,23 @@
+/*
+ * IRQ-driven SID sound driver (sound.s), ticked by the frame IRQ.
+ */
+
+#ifndef SOUND_H
+#define SOUND_H
+
+#ifndef __CC65__
+#define __fastcall__ /* host build (host.c): silent stubs */
+#endif
+
+/* Effect IDs; columns of the effect table in sound.s */
+#define SFX_LAUNCH 0
+#define SFX_EXPLODE 1
+
+/* Call snd_init before frame_init and snd_shutdown after frame_shutdown */
+void snd_init(void);
+void snd_shutdown(void);
+
+/* Queues an effect for the next frame tick; dropped if the queue is full */
+void __fastcall__ snd_play(unsigned char id);
+
+#endif /* SOUND_H */
@@ -0,0 +1,249 @@
+;
+; IRQ-driven SID sound driver.
+;
+; The main loop only calls snd_play with an effect ID (sound.h), which
+; appends it to a small single-producer/single-consumer ring: snd_play is
+; the only writer of q_head and snd_tick the only writer of q_tail, and
+; each is published with a single store, so neither side ever masks
+; interrupts. snd_tick runs from the frame IRQ (frame.s) once per video
+; frame. It starts every queued effect on a voice, then advances all
+; three voices: pitch sweep each tick and gate off when the effect's
+; time is up, leaving the envelope to release.
+;
+; Voice allocation takes a silent voice if there is one. Otherwise it
+; steals the lowest-priority voice whose priority does not exceed the new
+; effect's (the one closest to finishing on ties); if every voice plays
+; something more important the new effect is dropped.
+;
+
+        .export         _snd_init, _snd_shutdown, _snd_play
+        .export         snd_tick
+
+SID             = $D400                 ; voice n at SID + 7*n
+SID_VOLUME      = $D418
+QUEUE_SIZE      = 8                     ; power of two
+VOICES          = 3
+
+.segment        "RODATA"
+
+; Effect table, one column per field, indexed by effect ID (sound.h)
+;                       LAUNCH  EXPLODE
+fx_ctrl:        .byte   $10,    $80     ; waveform: triangle, noise
+fx_ad:          .byte   $59,    $08
+fx_sr:          .byte   $00,    $05
+fx_freq_lo:     .byte   <1000,  <4000
+fx_freq_hi:     .byte   >1000,  >4000
+fx_sweep_lo:    .byte   <24,    <-40    ; added to the pitch every tick
+fx_sweep_hi:    .byte   >24,    >-40
+fx_ticks:       .byte   40,     25      ; frames until gate off
+fx_prio:        .byte   1,      2
+fx_vary:        .byte   $FF,    $3F     ; random pitch offset mask (x4)
+
+voice_reg:      .byte   0, 7, 14
+
+.segment        "BSS"
+
+queue:          .res    QUEUE_SIZE
+q_head:         .res    1               ; next free slot (snd_play)
+q_tail:         .res    1               ; next unread slot (snd_tick)
+
+v_ticks:        .res    VOICES          ; 0 = silent or releasing
+v_prio:         .res    VOICES
+v_ctrl:         .res    VOICES
+v_freq_lo:      .res    VOICES
+v_freq_hi:      .res    VOICES
+v_sweep_lo:     .res    VOICES
+v_sweep_hi:     .res    VOICES
+
+fx:             .res    1
+best:           .res    1
+offset:         .res    2
+env_ad:         .res    1
+env_sr:         .res    1
+lfsr:           .res    1
+
+.segment        "CODE"
+
+; void snd_init (void);
+; Call before the frame IRQ is installed.
+.proc   _snd_init
+        lda     #0
+        ldx     #SID_VOLUME-SID
+@sid:   sta     SID,x
+        dex
+        bpl     @sid
+        ldx     #VOICES-1
+@voice: sta     v_ticks,x
+        sta     v_prio,x
+        dex
+        bpl     @voice
+        sta     q_head
+        sta     q_tail
+        lda     #$A5
+        sta     lfsr
+        lda     #15
+        sta     SID_VOLUME
+        rts
+.endproc
+
+; void snd_shutdown (void);
+; Call after the frame IRQ is removed.
+.proc   _snd_shutdown
+        lda     #0
+        sta     SID_VOLUME
+        ldx     #VOICES-1
+@voice: ldy     voice_reg,x
+        sta     SID+4,y
+        sta     v_ticks,x
+        dex
+        bpl     @voice
+        rts
+.endproc
+
+; void __fastcall__ snd_play (unsigned char id);
+.proc   _snd_play
+        ldx     q_head
+        sta     queue,x                 ; slot is free even when full
+        inx
+        txa
+        and     #QUEUE_SIZE-1
+        cmp     q_tail
+        beq     @full                   ; queue full: drop the effect
+        sta     q_head                  ; publish
+@full:  rts
+.endproc
+
+; Called from the frame IRQ; clobbers A, X, Y.
+.proc   snd_tick
+@queue: ldx     q_tail
+        cpx     q_head
+        beq     @voices
+        lda     queue,x
+        sta     fx
+        inx
+        txa
+        and     #QUEUE_SIZE-1
+        sta     q_tail
+        jsr     start
+        jmp     @queue
+
+@voices:
+        ldx     #VOICES-1
+@voice: lda     v_ticks,x
+        beq     @next
+        ldy     voice_reg,x
+        dec     v_ticks,x
+        bne     @sweep
+        lda     v_ctrl,x                ; time is up: gate off
+        sta     SID+4,y
+        jmp     @next
+@sweep: clc
+        lda     v_freq_lo,x
+        adc     v_sweep_lo,x
+        sta     v_freq_lo,x
+        sta     SID,y
+        lda     v_freq_hi,x
+        adc     v_sweep_hi,x
+        sta     v_freq_hi,x
+        sta     SID+1,y
+@next:  dex
+        bpl     @voice
+        rts
+.endproc
+
+; Starts effect `fx` on a voice, or drops it.
+.proc   start
+        ldx     #VOICES-1
+@free:  lda     v_ticks,x
+        beq     @got
+        dex
+        bpl     @free
+
+        ldy     fx                      ; all busy: pick a victim
+        lda     #$FF
+        sta     best
+        ldx     #VOICES-1
+@scan:  lda     v_prio,x
+        cmp     fx_prio,y
+        beq     @cand
+        bcs     @skip                   ; more important than the new one
+@cand:  lda     best
+        bmi     @take                   ; first candidate
+        stx     offset                  ; compare with voice `best`
+        ldx     best
+        lda     v_prio,x
+        ldx     offset
+        cmp     v_prio,x
+        beq     @tie
+        bcs     @take                   ; candidate has lower priority
+        bcc     @skip
+@tie:   ldx     best
+        lda     v_ticks,x
+        ldx     offset
+        cmp     v_ticks,x
+        bcc     @skip                   ; best finishes sooner
+        beq     @skip
+@take:  stx     best
+@skip:  dex
+        bpl     @scan
+        ldx     best
+        bpl     @got
+        rts
+
+@got:   ldy     fx
+        lda     fx_prio,y
+        sta     v_prio,x
+        lda     fx_ticks,y
+        sta     v_ticks,x
+        lda     fx_ctrl,y
+        sta     v_ctrl,x
+        lda     fx_sweep_lo,y
+        sta     v_sweep_lo,x
+        lda     fx_sweep_hi,y
+        sta     v_sweep_hi,x
+        lda     fx_ad,y
+        sta     env_ad
+        lda     fx_sr,y
+        sta     env_sr
+
+        lda     lfsr                    ; 8-bit Galois LFSR
+        asl     a
+        bcc     @lfsr
+        eor     #$1D
+@lfsr:  sta     lfsr
+        and     fx_vary,y               ; start pitch += (rnd & vary) * 4
+        sta     offset
+        lda     #0
+        asl     offset
+        rol     a
+        asl     offset
+        rol     a
+        sta     offset+1
+        clc
+        lda     fx_freq_lo,y
+        adc     offset
+        sta     v_freq_lo,x
+        lda     fx_freq_hi,y
+        adc     offset+1
+        sta     v_freq_hi,x
+
+        ldy     voice_reg,x
+        lda     #0
+        sta     SID+4,y                 ; gate off so the envelope restarts
+        lda     v_freq_lo,x
+        sta     SID,y
+        lda     v_freq_hi,x
+        sta     SID+1,y
+        lda     #$00
+        sta     SID+2,y                 ; 50% pulse width
+        lda     #$08
+        sta     SID+3,y
+        lda     env_ad
+        sta     SID+5,y
+        lda     env_sr
+        sta     SID+6,y
+        lda     v_ctrl,x
+        ora     #$01                    ; gate on
+        sta     SID+4,y
+        rts
+.endproc
@@ -0,0 +1,30 @@
+/*
+ * Sprite multiplexer (sprmux.s), driven by the frame IRQ in frame.s.
+ */
+
+#ifndef SPRMUX_H
+#define SPRMUX_H
+
+/* Virtual sprites per frame; keep in sync with sprmux.s */
+#define MUX_MAX 16
+
+/* Sprite coordinates of the top-left text cell */
+#define MUX_X_ORIGIN 24
+#define MUX_Y_ORIGIN 50
+
+/* One entry per virtual sprite, filled in any order before mux_commit */
+extern unsigned char mux_x_lo[MUX_MAX];
+extern unsigned char mux_x_hi[MUX_MAX];
+extern unsigned char mux_y[MUX_MAX];
+extern unsigned char mux_color[MUX_MAX];
+extern unsigned char mux_ptr[MUX_MAX];
+extern unsigned char mux_count;
+
+void mux_init(void);
+void mux_shutdown(void);
+
+/* Sorts the entries by Y and hands them to the IRQ for the next frame.
+ * Waits if the previous commit has not been picked up yet. */
+void mux_commit(void);
+
+#endif /* SPRMUX_H */
@@ -0,0 +1,301 @@
+;
+; Sprite multiplexer: up to MUX_MAX virtual sprites on the VIC-II's 8.
+;
+; The main loop fills the mux_* arrays (one entry per virtual sprite, any
+; order) and calls mux_commit once per frame. mux_commit insertion-sorts
+; the entries by Y, reusing last frame's order so a mostly static scene
+; costs one compare per sprite, and copies them into the back display
+; list. The raster IRQ (frame.s) swaps lists at the frame line, loads the
+; first eight sprites and then schedules one split per later sprite, at
+; the line where the hardware slot it reuses has finished drawing.
+; Sprites that start too close below the previous user of their slot are
+; dropped for that frame.
+;
+
+        .export         _mux_init, _mux_commit, _mux_shutdown
+        .export         _mux_x_lo, _mux_x_hi, _mux_y, _mux_color, _mux_ptr
+        .export         _mux_count
+        .export         mux_frame, mux_split
+
+MUX_MAX         = 16
+
+VIC_SPR_POS     = $D000                 ; x, y pairs for sprites 0-7
+VIC_SPR_HI_X    = $D010
+VIC_CTRL1       = $D011                 ; bit 7: raster bit 8
+VIC_RASTER      = $D012
+VIC_SPR_ENA     = $D015
+VIC_SPR_COLOR   = $D027
+SPR_POINTERS    = $07F8                 ; screen at $0400
+
+SPR_HEIGHT      = 21
+FRAME_IRQ_LINE  = 251                   ; keep in sync with frame.s
+
+.segment        "RODATA"
+
+slot_bit:       .byte   $01, $02, $04, $08, $10, $20, $40, $80
+enable_mask:    .byte   $00, $01, $03, $07, $0F, $1F, $3F, $7F, $FF
+
+.segment        "BSS"
+
+; Written by the main loop
+_mux_x_lo:      .res    MUX_MAX
+_mux_x_hi:      .res    MUX_MAX         ; bit 8 of X: 0 or 1
+_mux_y:         .res    MUX_MAX
+_mux_color:     .res    MUX_MAX
+_mux_ptr:       .res    MUX_MAX
+_mux_count:     .res    1
+
+; Sort state, kept between frames
+order:          .res    MUX_MAX
+order_n:        .res    1
+sort_i:         .res    1
+sort_key:       .res    1
+sort_key_y:     .res    1
+
+; Two sorted display lists, at offset 0 and MUX_MAX
+buf_y:          .res    2*MUX_MAX
+buf_x_lo:       .res    2*MUX_MAX
+buf_x_hi:       .res    2*MUX_MAX
+buf_color:      .res    2*MUX_MAX
+buf_ptr:        .res    2*MUX_MAX
+front:          .res    1
+back:           .res    1
+back_n:         .res    1
+pending:        .res    1               ; back list ready to swap in
+
+; IRQ side
+next:           .res    1               ; next display list entry
+last:           .res    1               ; one past the last entry
+cursor:         .res    1               ; next hardware slot (mod 8)
+free_line:      .res    1
+slot_y:         .res    8
+
+.segment        "CODE"
+
+; void mux_init (void);
+.proc   _mux_init
+        lda     #0
+        sta     _mux_count
+        sta     order_n
+        sta     front
+        sta     back_n
+        sta     pending
+        sta     next
+        sta     last
+        sta     VIC_SPR_ENA
+        sta     VIC_SPR_HI_X
+        lda     #MUX_MAX
+        sta     back
+        rts
+.endproc
+
+; void mux_shutdown (void);
+.proc   _mux_shutdown
+        lda     #0
+        sta     VIC_SPR_ENA
+        rts
+.endproc
+
+; void mux_commit (void);
+; Must be called with the frame IRQ running.
+.proc   _mux_commit
+@wait:  lda     pending                 ; previous list not taken yet
+        bne     @wait
+
+        ldx     _mux_count
+        cpx     #MUX_MAX+1
+        bcc     @count
+        ldx     #MUX_MAX
+@count: cpx     order_n
+        beq     @sort
+        stx     order_n                 ; count changed: restart from
+        dex                             ; the identity permutation
+        bmi     @sort
+@ident: txa
+        sta     order,x
+        dex
+        bpl     @ident
+
+        ; Insertion sort of order[] by _mux_y
+@sort:  lda     #1
+        sta     sort_i
+@outer: lda     sort_i
+        cmp     order_n
+        bcs     @copy
+        tax
+        ldy     order,x
+        sty     sort_key
+        lda     _mux_y,y
+        sta     sort_key_y
+@inner: dex                             ; X = j
+        bmi     @place
+        ldy     order,x
+        lda     _mux_y,y
+        cmp     sort_key_y
+        beq     @place                  ; equal keys keep their order
+        bcc     @place
+        tya
+        sta     order+1,x               ; order[j+1] = order[j]
+        jmp     @inner
+@place: inx
+        lda     sort_key
+        sta     order,x
+        inc     sort_i
+        jmp     @outer
+
+        ; Sorted copy into the back list
+@copy:  ldx     back
+        lda     #0
+        sta     sort_i
+@entry: ldy     sort_i
+        cpy     order_n
+        beq     @done
+        lda     order,y
+        tay
+        lda     _mux_y,y
+        sta     buf_y,x
+        lda     _mux_x_lo,y
+        sta     buf_x_lo,x
+        lda     _mux_x_hi,y
+        sta     buf_x_hi,x
+        lda     _mux_color,y
+        sta     buf_color,x
+        lda     _mux_ptr,y
+        sta     buf_ptr,x
+        inx
+        inc     sort_i
+        jmp     @entry
+@done:  lda     order_n
+        sta     back_n
+        lda     #1
+        sta     pending
+        rts
+.endproc
+
+; Loads display list entry `next` into hardware slot `cursor`.
+.proc   place
+        ldx     next
+        lda     cursor
+        and     #$07
+        tay
+        lda     buf_color,x
+        sta     VIC_SPR_COLOR,y
+        lda     buf_ptr,x
+        sta     SPR_POINTERS,y
+        lda     buf_y,x
+        sta     slot_y,y
+        lda     buf_x_hi,x
+        beq     @lo
+        lda     slot_bit,y
+        ora     VIC_SPR_HI_X
+        bne     @hi                     ; always
+@lo:    lda     slot_bit,y
+        eor     #$FF
+        and     VIC_SPR_HI_X
+@hi:    sta     VIC_SPR_HI_X
+        tya
+        asl     a
+        tay
+        lda     buf_x_lo,x
+        sta     VIC_SPR_POS,y
+        lda     buf_y,x
+        sta     VIC_SPR_POS+1,y
+        inc     next
+        inc     cursor
+        rts
+.endproc
+
+; Called from the raster IRQ at the frame line. Swaps in a freshly
+; committed list, loads the first eight sprites and returns the first
+; split line in A (0: no splits this frame).
+.proc   mux_frame
+        lda     pending
+        beq     @keep
+        ldx     back
+        lda     front
+        sta     back
+        stx     front
+        lda     back_n
+        sta     last                    ; entry count for now
+        lda     #0
+        sta     pending
+        beq     @start                  ; always
+@keep:  lda     last                    ; redisplay the current list:
+        sec                             ; turn the end index back into
+        sbc     front                   ; a count
+        sta     last
+@start: ldx     last
+        cpx     #9
+        bcc     @mask
+        ldx     #8
+@mask:  lda     enable_mask,x
+        sta     VIC_SPR_ENA
+        lda     front
+        sta     next
+        clc
+        adc     last
+        sta     last
+        lda     #0
+        sta     cursor
+@first: lda     cursor
+        cmp     #8
+        bcs     mux_split
+        lda     next
+        cmp     last
+        bcs     mux_split
+        jsr     place
+        jmp     @first
+.endproc
+
+; Called from the raster IRQ at a split line (and tail-called by
+; mux_frame). Places every remaining sprite whose slot is free by now and
+; returns the next split line in A, or 0 when the list is done.
+.proc   mux_split
+@loop:  lda     next
+        cmp     last
+        bcs     @none
+        tax
+        lda     cursor
+        and     #$07
+        tay
+        lda     slot_y,y
+        cmp     #FRAME_IRQ_LINE-SPR_HEIGHT
+        bcs     @drop                   ; slot busy to the frame line
+        adc     #SPR_HEIGHT             ; C = 0
+        sta     free_line
+        adc     #2
+        cmp     buf_y,x
+        beq     @fits
+        bcc     @fits
+@drop:  inc     next                    ; starts before its slot is free
+        jmp     @loop
+@fits:  jsr     raster_line
+        clc
+        adc     #2
+        cmp     free_line
+        bcs     @wait
+        lda     free_line               ; come back when the slot is free
+        rts
+@wait:  jsr     raster_line
+        cmp     free_line
+        bcc     @wait
+        jsr     place
+        jmp     @loop
+@none:  lda     #0
+        rts
+.endproc
+
+; Current line of the frame being shown, in A. The lines from the frame
+; line to the end of the frame (256 up included, where $D012 wraps) come
+; before the next frame's sprites, so they read as 0. Bit 8 is read first,
+; so a read across the 255/256 step or the wrap to line 0 also gives 0.
+.proc   raster_line
+        lda     VIC_CTRL1
+        bmi     @top
+        lda     VIC_RASTER
+        cmp     #FRAME_IRQ_LINE
+        bcs     @top
+        rts
+@top:   lda     #0
+        rts
+.endproc
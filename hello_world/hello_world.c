@@ -1,9 +1,10 @@
-// C64 Hello World Program using cc65's conio.h
-// Demonstrates basic screen operations and text output
+// C64 Hello World Program
+// Demonstrates basic screen operations and text output, written straight
+// to screen and colour RAM through c64screen instead of conio
 // @ulasb, 2025/12/20
 
-#include <conio.h>
-#include <stdio.h>
+#include "c64screen.h"
+#include "input.h"
 
 // Screen position constants for better readability
 #define CENTER_COL      11
@@ -29,24 +30,30 @@
 #define C64_COLOR_LIGHTBLUE    14
 #define C64_COLOR_LIGHTGRAY    15
 
+// Messages, converted to screen codes by the compiler
+#include <cbm_screen_charmap.h>
+static const char greeting[] = "Hello, C64 World!";
+static const char prompt[] = "Press any key to exit...";
+#include <cbm_petscii_charmap.h>
+
 int main(void) {
-    // Clear the screen and set up initial display
-    clrscr();
+    unsigned char key;
 
-    // Set text color to cyan for the main message
-    textcolor(C64_COLOR_CYAN);
+    // Clear the screen, keeping the default light blue text colour
+    scr_fill(SCR_SPACE, C64_COLOR_LIGHTBLUE);
 
-    // Display the main greeting message in the center of the screen
-    gotoxy(CENTER_COL, CENTER_ROW);
-    cprintf("Hello, C64 World!");
+    // Display the main greeting message in the center of the screen, in cyan
+    scr_puts(CENTER_COL, CENTER_ROW, C64_COLOR_CYAN, greeting);
 
-    // Change color and display secondary message at bottom
-    textcolor(C64_COLOR_GREEN);
-    gotoxy(BOTTOM_COL, BOTTOM_ROW);
-    cprintf("Press any key to exit...");
+    // Display the secondary message at the bottom, in green
+    scr_puts(BOTTOM_COL, BOTTOM_ROW, C64_COLOR_GREEN, prompt);
 
-    // Wait for user input before exiting
-    cgetc();
+    // Wait for a key press (or joystick) from the CIA1 scanner instead of
+    // the KERNAL keyboard buffer
+    in_start();
+    while ((key = in_get()) == IN_NONE || (key & IN_RELEASE))
+        ;
+    in_stop();
 
     return 0;
 }
@@ -0,0 +1,123 @@
+// md5_lib benchmark: exact 6502 cycle counts for the public API, timed
+// with the CIA2 counter in ../c64lib/ciatimer.c.
+//
+// Results are printed, kept in bench_results (look for the ASCII magic
+// "MD5B" in a memory dump) and written to "bench.csv" on device 8 as
+// name,bytes,cycles lines. bench.sh runs this headless in VICE.
+
+#include <c64.h>
+#include <cbm.h>
+#include <stdio.h>
+#include <string.h>
+#include "ciatimer.h"
+#include "md5.h"
+
+#define BENCH_DEV   8
+#define BENCH_LFN   2
+#define NUM_RESULTS 8
+#define MAX_INPUT   16384
+
+typedef struct {
+    char name[10];
+    uint32_t bytes;
+    uint32_t cycles;
+} bench_result_t;
+
+struct {
+    unsigned char magic[4];     // "MD5B" in ASCII, not PETSCII
+    unsigned char count;
+    bench_result_t r[NUM_RESULTS];
+} bench_results = { { 0x4d, 0x44, 0x35, 0x42 }, 0 };
+
+static unsigned char input[MAX_INPUT];
+static MD5_CTX context;
+static unsigned char digest[16];
+static char line[40];
+
+void record(const char *name, uint32_t bytes, uint32_t cycles) {
+    bench_result_t *r = &bench_results.r[bench_results.count++];
+    strcpy(r->name, name);
+    r->bytes = bytes;
+    r->cycles = cycles;
+}
+
+void bench_update(uint32_t len) {
+    MD5Init(&context);
+    timer_start();
+    MD5Update(&context, input, len);
+    record("update", len, timer_stop());
+}
+
+void run_benchmarks(void) {
+    timer_calibrate();
+
+    // One MD5UpdateBlocks block is MD5Transform plus a few compares
+    MD5Init(&context);
+    timer_start();
+    MD5UpdateBlocks(&context, input, 1);
+    record("transform", 64, timer_stop());
+
+    bench_update(0);
+    bench_update(64);
+    bench_update(1024);
+    bench_update(MAX_INPUT);
+
+    // Final on an empty context pads one block; with 56 bytes buffered it
+    // needs two.
+    MD5Init(&context);
+    timer_start();
+    MD5Final(digest, &context);
+    record("final", 0, timer_stop());
+
+    MD5Init(&context);
+    MD5Update(&context, input, 56);
+    timer_start();
+    MD5Final(digest, &context);
+    record("final", 56, timer_stop());
+}
+
+void write_csv(void) {
+    unsigned char i;
+    int n;
+
+    if (cbm_open(BENCH_LFN, BENCH_DEV, 2, "bench.csv,s,w") != 0) {
+        printf("no device %d, results in memory only\n", BENCH_DEV);
+        return;
+    }
+    for (i = 0; i < bench_results.count; i++) {
+        n = sprintf(line, "%s,%lu,%lu\n", bench_results.r[i].name,
+                    (unsigned long)bench_results.r[i].bytes,
+                    (unsigned long)bench_results.r[i].cycles);
+        cbm_write(BENCH_LFN, line, n);
+    }
+    cbm_close(BENCH_LFN);
+}
+
+int main() {
+    unsigned char i;
+    unsigned int n;
+
+    for (n = 0; n < MAX_INPUT; n++) {
+        input[n] = (unsigned char)n;
+    }
+
+    printf("MD5 Benchmark\n");
+    printf("-------------\n");
+
+    VIC.ctrl1 &= 0xef;      // blank screen: no badlines
+    __asm__ ("sei");
+    run_benchmarks();
+    __asm__ ("cli");
+    VIC.ctrl1 |= 0x10;
+
+    for (i = 0; i < bench_results.count; i++) {
+        bench_result_t *r = &bench_results.r[i];
+        printf("%-9s %5lu %9lu", r->name, (unsigned long)r->bytes, (unsigned long)r->cycles);
+        if (r->bytes != 0)
+            printf(" %5lu c/b", (unsigned long)(r->cycles / r->bytes));
+        printf("\n");
+    }
+
+    write_csv();
+    return 0;
+}
@@ -0,0 +1,45 @@
+#!/bin/sh
+# Runs bench.prg headless in VICE and prints cycles per byte for each
+# measurement. bench.prg writes bench.csv to device 8, which is mapped to
+# a temporary host directory.
+#
+# Usage: ./bench.sh [bench.prg]
+#   X64SC         emulator binary (default: x64sc)
+#   BENCH_CYCLES  cycle limit before VICE exits (default: 400000000)
+#   BENCH_LOG     if set, append "commit,name,bytes,cycles" rows to this file
+
+set -e
+
+X64SC=${X64SC:-x64sc}
+PRG=${1:-bench.prg}
+LIMIT=${BENCH_CYCLES:-400000000}
+
+WORK=$(mktemp -d)
+trap 'rm -rf "$WORK"' EXIT
+cp "$PRG" "$WORK/bench.prg"
+
+# VICE exits with a non-zero status when -limitcycles is reached
+"$X64SC" -default -warp -limitcycles "$LIMIT" -sounddev dummy \
+    +drive8truedrive -iecdevice8 -device8 1 -fs8 "$WORK" \
+    -autostartprgmode 1 -autostart "$WORK/bench.prg" >/dev/null 2>&1 || true
+
+CSV=$(find "$WORK" -maxdepth 1 -iname 'bench.csv*' | head -n 1)
+if [ -z "$CSV" ]; then
+    echo "bench.sh: bench.csv was not written (raise BENCH_CYCLES?)" >&2
+    exit 1
+fi
+
+# The C64 writes PETSCII: CR line ends, and lowercase names come out as
+# ASCII capitals.
+tr '\r' '\n' < "$CSV" | tr 'A-Z' 'a-z' | grep -v '^$' > "$WORK/results.csv"
+
+printf '%-10s %6s %10s %9s\n' routine bytes cycles cyc/byte
+awk -F, '{
+    if ($2 > 0) printf "%-10s %6d %10d %9.1f\n", $1, $2, $3, $3 / $2;
+    else        printf "%-10s %6d %10d %9s\n", $1, $2, $3, "-";
+}' "$WORK/results.csv"
+
+if [ -n "$BENCH_LOG" ]; then
+    COMMIT=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+    sed "s/^/$COMMIT,/" "$WORK/results.csv" >> "$BENCH_LOG"
+fi
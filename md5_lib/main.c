@@ -4,28 +4,56 @@
 
 int errors = 0;
 
-void print_digest(unsigned char *digest) {
+// Deterministic test data. Splits and the large tests use a byte pattern
+// whose digests were computed on the host with Python's hashlib.
+#ifdef __CC65__
+#define PATTERN_LEN 1000
+#define PATTERN_MD5 "b734d05775d6e6c54bcc784940b64443"
+#define SPLIT_ROUNDS 8
+#else
+#define PATTERN_LEN 65536UL
+#define PATTERN_MD5 "103855eeda762363187feb7a44c9e4a0"
+#define SPLIT_ROUNDS 500
+#endif
+
+static unsigned char pattern[PATTERN_LEN];
+
+void fill_pattern(void) {
+    uint32_t j;
+    for (j = 0; j < PATTERN_LEN; j++) {
+        pattern[j] = (unsigned char)(j * 31 + (j >> 8));
+    }
+}
+
+// 16-bit xorshift, cheap on the 6502
+static unsigned int rnd_state = 0xACE1;
+
+unsigned int rnd(void) {
+    rnd_state ^= rnd_state << 7;
+    rnd_state ^= rnd_state >> 9;
+    rnd_state ^= rnd_state << 8;
+    return rnd_state;
+}
+
+void print_digest(const unsigned char *digest) {
     int i;
     for(i = 0; i < 16; i++) {
         printf("%02x", digest[i]);
     }
 }
 
-void verify_md5_bytes(const unsigned char *bytes, uint32_t len, const char *label, const char *expected) {
-    MD5_CTX context;
-    unsigned char digest[16];
-    char output[33];
+void format_digest(const unsigned char *digest, char *output) {
     int i;
-
-    MD5Init(&context);
-    MD5Update(&context, bytes, len);
-    MD5Final(digest, &context);
-
-    // Format digest into output string
     for(i = 0; i < 16; i++) {
         sprintf(output + (i * 2), "%02x", digest[i]);
     }
     output[32] = 0;
+}
+
+void check_digest(const unsigned char *digest, const char *label, const char *expected) {
+    char output[33];
+
+    format_digest(digest, output);
 
     printf("MD5(%s) = ", label);
     print_digest(digest);
@@ -39,6 +67,322 @@ void verify_md5_bytes(const unsigned char *bytes, uint32_t len, const char *labe
     }
 }
 
+void verify_md5_bytes(const unsigned char *bytes, uint32_t len, const char *label, const char *expected) {
+    MD5_CTX context;
+    unsigned char digest[16];
+
+    MD5Init(&context);
+    MD5Update(&context, bytes, len);
+    MD5Final(digest, &context);
+
+    check_digest(digest, label, expected);
+}
+
+// The remaining RFC 1321 appendix A.5 vectors, built as ASCII bytes
+void verify_md5_rfc(void) {
+    static unsigned char text[80];
+    unsigned char i;
+
+    for (i = 0; i < 26; i++) {
+        text[i] = 0x61 + i;                                 // a-z
+    }
+    verify_md5_bytes(text, 26, "a..z", "c3fcd3d76192e4007dfb496cca67e13b");
+
+    for (i = 0; i < 62; i++) {
+        text[i] = i < 26 ? 0x41 + i : i < 52 ? 0x61 + i - 26 : 0x30 + i - 52;
+    }
+    verify_md5_bytes(text, 62, "A..Za..z0..9", "d174ab98d277d9f5a5611c2c9f419d9f");
+
+    for (i = 0; i < 80; i++) {
+        text[i] = 0x30 + (i + 1) % 10;                      // "1234567890" x 8
+    }
+    verify_md5_bytes(text, 80, "1234567890 x 8", "57edf4a22be3c955ac49da2e2107b67a");
+}
+
+// Streaming must not depend on how the input is split: feed the pattern
+// in random-sized pieces, including empty and multi-block ones.
+void verify_md5_splits(void) {
+    MD5_CTX context;
+    unsigned char digest[16];
+    char output[33];
+    uint32_t pos, chunk;
+    int round, bad = 0;
+
+    for (round = 0; round < SPLIT_ROUNDS; round++) {
+        MD5Init(&context);
+        pos = 0;
+        while (pos < PATTERN_LEN) {
+            chunk = rnd() & ((round & 1) ? 0x3F : 0x1FF);
+            if ((rnd() & 0x0F) == 0)
+                chunk = 0;
+            if (chunk > PATTERN_LEN - pos)
+                chunk = PATTERN_LEN - pos;
+            MD5Update(&context, pattern + pos, chunk);
+            pos += chunk;
+        }
+        MD5Final(digest, &context);
+        format_digest(digest, output);
+        if (strcmp(output, PATTERN_MD5) != 0)
+            bad++;
+    }
+
+    printf("MD5(pattern, %d random splits)", SPLIT_ROUNDS);
+    if (bad == 0) {
+        printf(" [PASS]\n");
+    } else {
+        printf(" [FAIL] %d mismatches\n", bad);
+        errors++;
+    }
+}
+
+// count[0] holds the bit count mod 2^32 and wraps every 512 MB. Start from
+// a count just below the wrap so the carry into count[1] is exercised on
+// the 6502 too. Expected digest from an independent Python MD5 with the
+// same starting count.
+void verify_md5_carry(void) {
+    MD5_CTX context;
+    unsigned char digest[16];
+
+    MD5Init(&context);
+    context.count[0] = 0xFFFFFC00UL;    // 0x1FFFFF80 bytes already hashed
+    MD5Update(&context, pattern, 300);
+    if (context.count[0] != 0x560 || context.count[1] != 1) {
+        printf("count carry fail: %08lx %08lx\n",
+               (unsigned long)context.count[1], (unsigned long)context.count[0]);
+        errors++;
+    }
+    MD5Final(digest, &context);
+    check_digest(digest, "count[0] carry", "3232a1bc4845327333bf82c705d65e48");
+}
+
+// Checkpoint mid-block with MD5Export, resume in a fresh context with
+// MD5Import, and finish: the digest must match an uninterrupted run.
+// Damaged or truncated blobs must be rejected.
+void verify_md5_export(void) {
+    static uint8_t blob[MD5_EXPORT_MAX];
+    MD5_CTX context, resumed;
+    unsigned char digest[16];
+    unsigned int len;
+    int ok = 1;
+
+    MD5Init(&context);
+    MD5Update(&context, pattern, 300);          // 44 bytes left buffered
+    len = MD5Export(blob, &context);
+    if (len != 27 + 44 + 1)
+        ok = 0;
+
+    memset(&resumed, 0xA5, sizeof(resumed));
+    if (MD5Import(&resumed, blob, len) != 0)
+        ok = 0;
+    MD5Update(&resumed, pattern + 300, PATTERN_LEN - 300);
+    MD5Final(digest, &resumed);
+    check_digest(digest, "pattern, export/import", PATTERN_MD5);
+
+    if (MD5Import(&resumed, blob, len - 1) == 0)
+        ok = 0;
+    blob[10] ^= 0x01;
+    if (MD5Import(&resumed, blob, len) == 0)
+        ok = 0;
+
+    printf("MD5Import rejects bad blobs");
+    if (ok) {
+        printf(" [PASS]\n");
+    } else {
+        printf(" [FAIL]\n");
+        errors++;
+    }
+}
+
+#ifdef __C64__
+// MD5UpdateREU: stash the pattern in the REU at an odd address that
+// crosses a 64 KB bank, then hash it back out by DMA after a few bytes
+// from main RAM. Skipped without an REU (VICE: x64sc -reu).
+#define REU_REG ((volatile unsigned char *)0xDF00)
+#define REU_TEST_ADDR 0xFFF3UL
+
+int reu_present(void) {
+    REU_REG[2] = 0x55;
+    REU_REG[3] = 0xAA;
+    return REU_REG[2] == 0x55 && REU_REG[3] == 0xAA;
+}
+
+void reu_stash(const unsigned char *src, uint32_t dst, unsigned int len) {
+    REU_REG[2] = (unsigned int)src & 0xFF;
+    REU_REG[3] = (unsigned int)src >> 8;
+    REU_REG[4] = dst & 0xFF;
+    REU_REG[5] = (dst >> 8) & 0xFF;
+    REU_REG[6] = (dst >> 16) & 0xFF;
+    REU_REG[7] = len & 0xFF;
+    REU_REG[8] = len >> 8;
+    REU_REG[10] = 0;
+    REU_REG[1] = 0x90;          // execute now, C64 -> REU
+}
+
+void verify_md5_reu(void) {
+    MD5_CTX context;
+    unsigned char digest[16];
+
+    if (!reu_present()) {
+        printf("MD5UpdateREU [SKIP] no REU\n");
+        return;
+    }
+    reu_stash(pattern, REU_TEST_ADDR, PATTERN_LEN);
+    MD5Init(&context);
+    MD5Update(&context, pattern, 7);
+    MD5UpdateREU(&context, REU_TEST_ADDR + 7, PATTERN_LEN - 7);
+    MD5Final(digest, &context);
+    check_digest(digest, "pattern, REU", PATTERN_MD5);
+}
+#endif
+
+#if !defined(__CC65__) || defined(MD5_TEST_LARGE)
+// Real multi-megabyte inputs. Hours on the 6502 with the C transform, so
+// only built for the host unless MD5_TEST_LARGE is defined.
+void verify_md5_large(void) {
+    MD5_CTX context;
+    unsigned char digest[16];
+    uint32_t i;
+
+    // 1,000,000 x 'a'
+    memset(pattern, 0x61, 1000);
+    MD5Init(&context);
+    for (i = 0; i < 1000; i++) {
+        MD5Update(&context, pattern, 1000);
+    }
+    MD5Final(digest, &context);
+    check_digest(digest, "a x 1000000", "7707d6ae4e027c70eea2a935c2296f21");
+    fill_pattern();
+
+#ifndef __CC65__
+    // 537 MB: crosses the count[0] wrap for real
+    MD5Init(&context);
+    for (i = 0; i < 8200; i++) {
+        MD5Update(&context, pattern, PATTERN_LEN);
+    }
+    MD5Update(&context, pattern, 1234);
+    MD5Final(digest, &context);
+    check_digest(digest, "pattern x 8200 + 1234", "16344059e37842fa46ac0c719f77ab51");
+#endif
+}
+#endif
+
+/* MD5UpdateBlocks and odd-aligned MD5Update input must match a plain
+   MD5Update of the same bytes. */
+void verify_md5_blocks(void) {
+    static unsigned char data[1 + 192];
+    MD5_CTX context;
+    unsigned char ref[16], digest[16];
+    int i, ok = 1;
+
+    for (i = 0; i < (int)sizeof(data); i++)
+        data[i] = (unsigned char)(i * 13);
+
+    MD5Init(&context);
+    MD5Update(&context, data, 192);
+    MD5Final(ref, &context);
+
+    MD5Init(&context);
+    MD5UpdateBlocks(&context, data, 1);
+    MD5UpdateBlocks(&context, data + 64, 2);
+    MD5Final(digest, &context);
+    if (memcmp(ref, digest, 16) != 0)
+        ok = 0;
+
+    /* Shifted copy: exercises the unaligned Decode path on the host */
+    memmove(data + 1, data, 192);
+    MD5Init(&context);
+    MD5Update(&context, data + 1, 192);
+    MD5Final(digest, &context);
+    if (memcmp(ref, digest, 16) != 0)
+        ok = 0;
+
+    printf("MD5UpdateBlocks/unaligned");
+    if (ok) {
+        printf(" [PASS]\n");
+    } else {
+        printf(" [FAIL]\n");
+        errors++;
+    }
+}
+
+#ifndef __CC65__
+/* Host only: MD5UpdateN must match MD5Update lane for lane, including
+   contexts that start with a partly filled buffer. */
+#define MB_JOBS 37
+
+void verify_md5_batch(void) {
+    static unsigned char data[MB_JOBS][700];
+    MD5_CTX batch[MB_JOBS], ref[MB_JOBS];
+    MD5_CTX *ctxs[MB_JOBS];
+    const uint8_t *inputs[MB_JOBS];
+    uint32_t lens[MB_JOBS];
+    unsigned char d1[16], d2[16];
+    unsigned int i, j, bad = 0;
+
+    for (i = 0; i < MB_JOBS; i++) {
+        for (j = 0; j < sizeof(data[i]); j++)
+            data[i][j] = (unsigned char)(i * 31 + j * 7);
+        MD5Init(&batch[i]);
+        MD5Init(&ref[i]);
+        /* Odd jobs start mid-block */
+        if (i & 1) {
+            MD5Update(&batch[i], data[i], i);
+            MD5Update(&ref[i], data[i], i);
+        }
+        ctxs[i] = &batch[i];
+        inputs[i] = data[i] + (i & 1 ? i : 0);
+        lens[i] = (uint32_t)((i * 97) % (sizeof(data[i]) - MB_JOBS));
+    }
+
+    MD5UpdateN(ctxs, inputs, lens, MB_JOBS);
+
+    for (i = 0; i < MB_JOBS; i++) {
+        MD5Update(&ref[i], inputs[i], lens[i]);
+        MD5Final(d1, &batch[i]);
+        MD5Final(d2, &ref[i]);
+        if (memcmp(d1, d2, 16) != 0)
+            bad++;
+    }
+
+    printf("MD5UpdateN(%d jobs)", MB_JOBS);
+    if (bad == 0) {
+        printf(" [PASS]\n");
+    } else {
+        printf(" [FAIL] %u mismatches\n", bad);
+        errors++;
+    }
+
+    /* A context listed twice absorbs both inputs in array order */
+    bad = 0;
+    for (i = 0; i < MB_JOBS; i++) {
+        MD5Init(&batch[i]);
+        MD5Init(&ref[i]);
+        ctxs[i] = &batch[i % 5];
+        inputs[i] = data[i];
+        lens[i] = (uint32_t)((i * 53) % sizeof(data[i]));
+    }
+
+    MD5UpdateN(ctxs, inputs, lens, MB_JOBS);
+
+    for (i = 0; i < MB_JOBS; i++)
+        MD5Update(&ref[i % 5], inputs[i], lens[i]);
+    for (i = 0; i < 5; i++) {
+        MD5Final(d1, &batch[i]);
+        MD5Final(d2, &ref[i]);
+        if (memcmp(d1, d2, 16) != 0)
+            bad++;
+    }
+
+    printf("MD5UpdateN(repeated contexts)");
+    if (bad == 0) {
+        printf(" [PASS]\n");
+    } else {
+        printf(" [FAIL] %u mismatches\n", bad);
+        errors++;
+    }
+}
+#endif
+
 int main() {
     unsigned char a_byte[] = { 0x61 }; // 'a' in ASCII
     unsigned char abc_bytes[] = { 0x61, 0x62, 0x63 }; // "abc" in ASCII
@@ -55,6 +399,24 @@ int main() {
     verify_md5_bytes(a_byte, 1, "\"a\"", "0cc175b9c0f1b6a831c399e269772661");
     verify_md5_bytes(abc_bytes, 3, "\"abc\"", "900150983cd24fb0d6963f7d28e17f72");
     verify_md5_bytes(msg_bytes, 14, "\"message digest\"", "f96b697d7cb7938d525a2f31aaf161d0");
+    verify_md5_rfc();
+
+    fill_pattern();
+    verify_md5_blocks();
+    verify_md5_splits();
+    verify_md5_carry();
+    verify_md5_export();
+#ifdef __C64__
+    verify_md5_reu();
+#endif
+
+#if !defined(__CC65__) || defined(MD5_TEST_LARGE)
+    verify_md5_large();
+#endif
+
+#ifndef __CC65__
+    verify_md5_batch();
+#endif
 
     if (errors == 0) {
         printf("\nAll tests passed!\n");
@@ -62,5 +424,6 @@ int main() {
         printf("\n%d tests failed.\n", errors);
     }
 
-    return 0;
+    // Non-zero exit fails "make test" under sim65 and on the host
+    return errors != 0;
 }
@@ -2,6 +2,23 @@
 #include <string.h>
 #include <stdio.h>
 
+/* Message words can be read straight out of the caller's block when the
+   target is little-endian and the block is suitably aligned. The 6502 has
+   no alignment rules, so cc65 always takes the direct path. */
+#if defined(__CC65__)
+#define MD5_DIRECT_LOAD(p) 1
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MD5_DIRECT_LOAD(p) ((((uintptr_t)(p)) & 3) == 0)
+#else
+#define MD5_DIRECT_LOAD(p) 0
+#endif
+
+#ifdef __GNUC__
+typedef uint32_t __attribute__((may_alias)) md5_word_t;
+#else
+typedef uint32_t md5_word_t;
+#endif
+
 #ifdef MD5_DEBUG
 #define MD5_LOG(...) printf(__VA_ARGS__)
 #else
@@ -26,7 +43,22 @@
 #define S43 15
 #define S44 21
 
+/* Transform size/speed trade-off (C transform only):
+   0: fully unrolled, 64 inline steps (fastest, largest)
+   1: one loop per round, 4 inline steps per iteration, constants and
+      message indices from tables
+   2: a single generic step driven by tables (smallest, slowest) */
+#ifndef MD5_SMALL
+#define MD5_SMALL 0
+#endif
+
+#ifdef MD5_ASM_TRANSFORM
+/* Hand-written 6502 version in md5_transform.s */
+void __fastcall__ MD5Transform(uint32_t [4], const uint8_t [64]);
+#else
 static void MD5Transform(uint32_t [4], const uint8_t [64]);
+#endif
+static void AddCount(MD5_CTX *, uint32_t);
 static void Encode(uint8_t *, const uint32_t *, unsigned int);
 static void Decode(uint32_t *, const uint8_t *, unsigned int);
 
@@ -103,21 +135,21 @@ void MD5Update(MD5_CTX *context, const uint8_t *input, uint32_t inputLen)
   MD5_LOG("Update: len=%lu, index=%lu, cnt0=%08lx\n", (unsigned long)inputLen, (unsigned long)index, (unsigned long)context->count[0]);
 
   /* Update number of bits */
-  {
-      uint32_t add_bits = ((uint32_t)inputLen << 3);
-      if ((context->count[0] += add_bits) < add_bits)
-        context->count[1]++;
-      context->count[1] += ((uint32_t)inputLen >> 29);
-  }
+  AddCount(context, inputLen);
 
   partLen = 64 - index;
 
   /* Transform as many times as possible. */
   if (inputLen >= partLen) {
-    memcpy(&context->buffer[index], input, (unsigned int)partLen);
-    MD5Transform(context->state, context->buffer);
-
-    for (i = partLen; i + 63 < inputLen; i += 64)
+    if (index != 0) {
+      memcpy(&context->buffer[index], input, (unsigned int)partLen);
+      MD5Transform(context->state, context->buffer);
+      i = partLen;
+    }
+    else
+      i = 0; /* Nothing buffered: transform straight from input */
+
+    for (; i + 63 < inputLen; i += 64)
       MD5Transform(context->state, &input[i]);
 
     index = 0;
@@ -129,6 +161,25 @@ void MD5Update(MD5_CTX *context, const uint8_t *input, uint32_t inputLen)
   memcpy(&context->buffer[index], &input[i], (unsigned int)(inputLen-i));
 }
 
+/* MD5 whole-block update. Like MD5Update with blocks * 64 bytes, for
+  callers that only ever feed whole 64-byte blocks: every block is
+  transformed in place from input, with no buffering. Falls back to
+  MD5Update if earlier input left a partial block in the context. */
+void MD5UpdateBlocks(MD5_CTX *context, const uint8_t *input, unsigned int blocks)
+{
+  if (context->count[0] & 0x1FF) {
+    MD5Update(context, input, (uint32_t)blocks << 6);
+    return;
+  }
+
+  AddCount(context, (uint32_t)blocks << 6);
+
+  while (blocks--) {
+    MD5Transform(context->state, input);
+    input += 64;
+  }
+}
+
 /* MD5 finalization. Ends an MD5 message-digest operation, writing the
   the message digest and zeroizing the context. */
 void MD5Final(uint8_t digest[16], MD5_CTX *context)
@@ -154,17 +205,169 @@ void MD5Final(uint8_t digest[16], MD5_CTX *context)
   memset(context, 0, sizeof(*context));
 }
 
+/* Serialized context layout, all multi-byte fields lsb first:
+     0  magic 'M' '5' (ASCII)     2  version
+     3  state[4]                 19  count[2]
+    27  buffered bytes (count/8 mod 64 of them)
+     n  8-bit sum of all preceding bytes */
+#define MD5_BLOB_VERSION 1
+#define MD5_BLOB_HEADER 27
+
+static uint8_t BlobSum(const uint8_t *blob, unsigned int len)
+{
+  uint8_t sum = 0;
+
+  while (len--)
+    sum += *blob++;
+  return sum;
+}
+
+/* Writes a resumable snapshot of context to blob (at most
+  MD5_EXPORT_MAX bytes) and returns its length. The context is left
+  untouched, so hashing can continue. */
+unsigned int MD5Export(uint8_t *blob, const MD5_CTX *context)
+{
+  unsigned int partial = (unsigned int)((context->count[0] >> 3) & 0x3F);
+  unsigned int len = MD5_BLOB_HEADER + partial;
+
+  blob[0] = 0x4D;
+  blob[1] = 0x35;
+  blob[2] = MD5_BLOB_VERSION;
+  Encode(&blob[3], context->state, 16);
+  Encode(&blob[19], context->count, 8);
+  memcpy(&blob[MD5_BLOB_HEADER], context->buffer, partial);
+  blob[len] = BlobSum(blob, len);
+
+  return len + 1;
+}
+
+/* Restores a context written by MD5Export. Returns 0 on success, or -1 if
+  the blob is truncated, corrupt or from another version, in which case
+  the context is not modified. */
+int MD5Import(MD5_CTX *context, const uint8_t *blob, unsigned int len)
+{
+  uint32_t count[2];
+  unsigned int partial;
+
+  if (len < MD5_BLOB_HEADER + 1 || blob[0] != 0x4D || blob[1] != 0x35 ||
+      blob[2] != MD5_BLOB_VERSION)
+    return -1;
+
+  Decode(count, &blob[19], 8);
+  partial = (unsigned int)((count[0] >> 3) & 0x3F);
+  if (len != MD5_BLOB_HEADER + partial + 1 ||
+      BlobSum(blob, len - 1) != blob[len - 1])
+    return -1;
+
+  Decode(context->state, &blob[3], 16);
+  context->count[0] = count[0];
+  context->count[1] = count[1];
+  memset(context->buffer, 0, sizeof(context->buffer));
+  memcpy(context->buffer, &blob[MD5_BLOB_HEADER], partial);
+
+  return 0;
+}
+
+#if !defined(MD5_ASM_TRANSFORM) && MD5_SMALL
+/* Per-step additive constants, message word indices and (for the generic
+   step) rotate amounts for the table-driven transforms. */
+static const uint32_t MD5_K[64] = {
+  0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+  0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+  0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+  0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+  0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+  0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+  0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+  0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static const uint8_t MD5_X[64] = {
+   0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15,
+   1,  6, 11,  0,  5, 10, 15,  4,  9, 14,  3,  8, 13,  2,  7, 12,
+   5,  8, 11, 14,  1,  4,  7, 10, 13,  0,  3,  6,  9, 12, 15,  2,
+   0,  7, 14,  5, 12,  3, 10,  1,  8, 15,  6, 13,  4, 11,  2,  9
+};
+
+#if MD5_SMALL == 2
+static const uint8_t MD5_S[16] = {
+  S11, S12, S13, S14, S21, S22, S23, S24, S31, S32, S33, S34, S41, S42, S43, S44
+};
+#endif
+#endif
+
+#ifndef MD5_ASM_TRANSFORM
 /* MD5 basic transformation. Transforms state based on block. */
 static void MD5Transform(uint32_t state[4], const uint8_t block[64])
 {
-  uint32_t a = state[0], b = state[1], c = state[2], d = state[3], x[16];
+  uint32_t a = state[0], b = state[1], c = state[2], d = state[3], xbuf[16];
+  const md5_word_t *x;
+#if MD5_SMALL
+  unsigned char i;
+#endif
+#if MD5_SMALL == 2
+  uint32_t t;
+#endif
 
-  Decode(x, block, 64);
+  if (MD5_DIRECT_LOAD(block))
+    x = (const md5_word_t *)block;
+  else {
+    Decode(xbuf, block, 64);
+    x = xbuf;
+  }
 
   MD5_LOG("# MD5Transform start:\n");
   MD5_LOG("  State: %08lx %08lx %08lx %08lx\n", (unsigned long)state[0], (unsigned long)state[1], (unsigned long)state[2], (unsigned long)state[3]);
   MD5_LOG("  Block[0-3]: %02x %02x %02x %02x\n", block[0], block[1], block[2], block[3]);
 
+#if MD5_SMALL == 2
+  /* One generic step. After each step the registers rotate: the new value
+     lands in b and the old d becomes the next a. */
+  for (i = 0; i < 64; i++) {
+    switch (i >> 4) {
+      case 0: t = F(b, c, d); break;
+      case 1: t = G(b, c, d); break;
+      case 2: t = H(b, c, d); break;
+      default: t = I(b, c, d); break;
+    }
+    t = (a + t + x[MD5_X[i]] + MD5_K[i]) & 0xFFFFFFFFUL;
+    t = ROTATE_LEFT(t, MD5_S[((i >> 2) & 0x0C) | (i & 3)]);
+    a = d;
+    d = c;
+    c = b;
+    b = (b + t) & 0xFFFFFFFFUL;
+  }
+#elif MD5_SMALL == 1
+  /* One loop per round; the four steps of a round are inline so the
+     function and rotate amounts stay compile-time constants. */
+  for (i = 0; i < 16; i += 4) {
+    FF (a, b, c, d, x[MD5_X[i  ]], S11, MD5_K[i  ]);
+    FF (d, a, b, c, x[MD5_X[i+1]], S12, MD5_K[i+1]);
+    FF (c, d, a, b, x[MD5_X[i+2]], S13, MD5_K[i+2]);
+    FF (b, c, d, a, x[MD5_X[i+3]], S14, MD5_K[i+3]);
+  }
+  MD5_LOG("  R1: %08lx %08lx %08lx %08lx\n", (unsigned long)a, (unsigned long)b, (unsigned long)c, (unsigned long)d);
+  for (; i < 32; i += 4) {
+    GG (a, b, c, d, x[MD5_X[i  ]], S21, MD5_K[i  ]);
+    GG (d, a, b, c, x[MD5_X[i+1]], S22, MD5_K[i+1]);
+    GG (c, d, a, b, x[MD5_X[i+2]], S23, MD5_K[i+2]);
+    GG (b, c, d, a, x[MD5_X[i+3]], S24, MD5_K[i+3]);
+  }
+  MD5_LOG("  R2: %08lx %08lx %08lx %08lx\n", (unsigned long)a, (unsigned long)b, (unsigned long)c, (unsigned long)d);
+  for (; i < 48; i += 4) {
+    HH (a, b, c, d, x[MD5_X[i  ]], S31, MD5_K[i  ]);
+    HH (d, a, b, c, x[MD5_X[i+1]], S32, MD5_K[i+1]);
+    HH (c, d, a, b, x[MD5_X[i+2]], S33, MD5_K[i+2]);
+    HH (b, c, d, a, x[MD5_X[i+3]], S34, MD5_K[i+3]);
+  }
+  MD5_LOG("  R3: %08lx %08lx %08lx %08lx\n", (unsigned long)a, (unsigned long)b, (unsigned long)c, (unsigned long)d);
+  for (; i < 64; i += 4) {
+    II (a, b, c, d, x[MD5_X[i  ]], S41, MD5_K[i  ]);
+    II (d, a, b, c, x[MD5_X[i+1]], S42, MD5_K[i+1]);
+    II (c, d, a, b, x[MD5_X[i+2]], S43, MD5_K[i+2]);
+    II (b, c, d, a, x[MD5_X[i+3]], S44, MD5_K[i+3]);
+  }
+#else
   /* Round 1 */
   FF (a, b, c, d, x[ 0], S11, 0xd76aa478); /* 1 */
   FF (d, a, b, c, x[ 1], S12, 0xe8c7b756); /* 2 */
@@ -242,6 +445,7 @@ static void MD5Transform(uint32_t state[4], const uint8_t block[64])
   II (d, a, b, c, x[11], S42, 0xbd3af235); /* 62 */
   II (c, d, a, b, x[ 2], S43, 0x2ad7d2bb); /* 63 */
   II (b, c, d, a, x[ 9], S44, 0xeb86d391); /* 64 */
+#endif
 
   MD5_LOG("  R4: %08lx %08lx %08lx %08lx\n", (unsigned long)a, (unsigned long)b, (unsigned long)c, (unsigned long)d);
 
@@ -251,7 +455,18 @@ static void MD5Transform(uint32_t state[4], const uint8_t block[64])
   state[3] += d;
 
   /* Zeroize sensitive information. */
-  memset(x, 0, sizeof(x));
+  if (x == xbuf)
+    memset(xbuf, 0, sizeof(xbuf));
+}
+#endif /* MD5_ASM_TRANSFORM */
+
+/* Adds inputLen bytes to the bit count, modulo 2^64. */
+static void AddCount(MD5_CTX *context, uint32_t inputLen)
+{
+  uint32_t add_bits = (inputLen << 3);
+  if ((context->count[0] += add_bits) < add_bits)
+    context->count[1]++;
+  context->count[1] += (inputLen >> 29);
 }
 
 /* Encodes input (uint32_t) into output (uint8_t). Assumes len is
@@ -12,8 +12,28 @@ typedef struct {
 
 void MD5Init(MD5_CTX *);
 void MD5Update(MD5_CTX *, const uint8_t *, uint32_t);
+void MD5UpdateBlocks(MD5_CTX *, const uint8_t *, unsigned int);
 void MD5Final(uint8_t[16], MD5_CTX *);
 
+/* Checkpointing: MD5Export writes a versioned snapshot of an unfinished
+   context (at most MD5_EXPORT_MAX bytes); MD5Import restores it. */
+#define MD5_EXPORT_MAX 91
+unsigned int MD5Export(uint8_t *, const MD5_CTX *);
+int MD5Import(MD5_CTX *, const uint8_t *, unsigned int);
+
+#ifdef __C64__
+/* C64 with a RAM Expansion Unit (md5_reu.c): hashes bytes stored in REU
+   memory, fetched by DMA. */
+void MD5UpdateREU(MD5_CTX *, uint32_t, uint32_t);
+#endif
+
+#ifndef __CC65__
+/* Host builds only (md5_mb.c): same as MD5Update on each context in
+   array order, using SIMD lanes where available. A context listed more
+   than once is allowed but takes the scalar path. */
+void MD5UpdateN(MD5_CTX *[], const uint8_t *[], const uint32_t [], unsigned int);
+#endif
+
 #ifdef MD5_DEBUG
 void MD5_Internal_Tests(void);
 #endif
@@ -0,0 +1,221 @@
+/* Multi-buffer MD5 for host builds.
+
+   MD5UpdateN hashes several independent messages at once by running one
+   message per SIMD lane (SSE2: 4, AVX2: 8, AVX-512: 16). The widest engine
+   the CPU supports is picked at the first call; MD5_MB_LANES=1/4/8/16 in
+   the environment forces a narrower one for testing. Without GCC/Clang on
+   x86 every call falls back to MD5Update, so digests are always identical
+   to the scalar path.
+
+   Not part of md5.lib on the C64. */
+
+#include "md5.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MD5_MB_X86
+#endif
+
+#ifdef MD5_MB_X86
+
+/* Adds len bytes to the bit count, exactly as MD5Update does. */
+static void md5_add_count(MD5_CTX *context, uint32_t len)
+{
+  uint32_t add_bits = len << 3;
+  if ((context->count[0] += add_bits) < add_bits)
+    context->count[1]++;
+  context->count[1] += len >> 29;
+}
+
+typedef uint32_t v4u32 __attribute__((vector_size(16)));
+typedef uint32_t v8u32 __attribute__((vector_size(32)));
+typedef uint32_t v16u32 __attribute__((vector_size(64)));
+
+/* Lane-wise versions of the md5.c basic functions. */
+#define MB_F(x, y, z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MB_G(x, y, z) ((y) ^ ((z) & ((x) ^ (y))))
+#define MB_H(x, y, z) ((x) ^ (y) ^ (z))
+#define MB_I(x, y, z) ((y) ^ ((x) | ~(z)))
+
+#define MB_STEP(f, a, b, c, d, x, s, ac) { \
+    (a) += f((b), (c), (d)) + (x) + (uint32_t)(ac); \
+    (a) = ((a) << (s)) | ((a) >> (32 - (s))); \
+    (a) += (b); \
+  }
+
+#define MB_ROUNDS(a, b, c, d, x) { \
+    MB_STEP(MB_F, a, b, c, d, x[ 0],  7, 0xd76aa478); \
+    MB_STEP(MB_F, d, a, b, c, x[ 1], 12, 0xe8c7b756); \
+    MB_STEP(MB_F, c, d, a, b, x[ 2], 17, 0x242070db); \
+    MB_STEP(MB_F, b, c, d, a, x[ 3], 22, 0xc1bdceee); \
+    MB_STEP(MB_F, a, b, c, d, x[ 4],  7, 0xf57c0faf); \
+    MB_STEP(MB_F, d, a, b, c, x[ 5], 12, 0x4787c62a); \
+    MB_STEP(MB_F, c, d, a, b, x[ 6], 17, 0xa8304613); \
+    MB_STEP(MB_F, b, c, d, a, x[ 7], 22, 0xfd469501); \
+    MB_STEP(MB_F, a, b, c, d, x[ 8],  7, 0x698098d8); \
+    MB_STEP(MB_F, d, a, b, c, x[ 9], 12, 0x8b44f7af); \
+    MB_STEP(MB_F, c, d, a, b, x[10], 17, 0xffff5bb1); \
+    MB_STEP(MB_F, b, c, d, a, x[11], 22, 0x895cd7be); \
+    MB_STEP(MB_F, a, b, c, d, x[12],  7, 0x6b901122); \
+    MB_STEP(MB_F, d, a, b, c, x[13], 12, 0xfd987193); \
+    MB_STEP(MB_F, c, d, a, b, x[14], 17, 0xa679438e); \
+    MB_STEP(MB_F, b, c, d, a, x[15], 22, 0x49b40821); \
+    MB_STEP(MB_G, a, b, c, d, x[ 1],  5, 0xf61e2562); \
+    MB_STEP(MB_G, d, a, b, c, x[ 6],  9, 0xc040b340); \
+    MB_STEP(MB_G, c, d, a, b, x[11], 14, 0x265e5a51); \
+    MB_STEP(MB_G, b, c, d, a, x[ 0], 20, 0xe9b6c7aa); \
+    MB_STEP(MB_G, a, b, c, d, x[ 5],  5, 0xd62f105d); \
+    MB_STEP(MB_G, d, a, b, c, x[10],  9,  0x2441453); \
+    MB_STEP(MB_G, c, d, a, b, x[15], 14, 0xd8a1e681); \
+    MB_STEP(MB_G, b, c, d, a, x[ 4], 20, 0xe7d3fbc8); \
+    MB_STEP(MB_G, a, b, c, d, x[ 9],  5, 0x21e1cde6); \
+    MB_STEP(MB_G, d, a, b, c, x[14],  9, 0xc33707d6); \
+    MB_STEP(MB_G, c, d, a, b, x[ 3], 14, 0xf4d50d87); \
+    MB_STEP(MB_G, b, c, d, a, x[ 8], 20, 0x455a14ed); \
+    MB_STEP(MB_G, a, b, c, d, x[13],  5, 0xa9e3e905); \
+    MB_STEP(MB_G, d, a, b, c, x[ 2],  9, 0xfcefa3f8); \
+    MB_STEP(MB_G, c, d, a, b, x[ 7], 14, 0x676f02d9); \
+    MB_STEP(MB_G, b, c, d, a, x[12], 20, 0x8d2a4c8a); \
+    MB_STEP(MB_H, a, b, c, d, x[ 5],  4, 0xfffa3942); \
+    MB_STEP(MB_H, d, a, b, c, x[ 8], 11, 0x8771f681); \
+    MB_STEP(MB_H, c, d, a, b, x[11], 16, 0x6d9d6122); \
+    MB_STEP(MB_H, b, c, d, a, x[14], 23, 0xfde5380c); \
+    MB_STEP(MB_H, a, b, c, d, x[ 1],  4, 0xa4beea44); \
+    MB_STEP(MB_H, d, a, b, c, x[ 4], 11, 0x4bdecfa9); \
+    MB_STEP(MB_H, c, d, a, b, x[ 7], 16, 0xf6bb4b60); \
+    MB_STEP(MB_H, b, c, d, a, x[10], 23, 0xbebfbc70); \
+    MB_STEP(MB_H, a, b, c, d, x[13],  4, 0x289b7ec6); \
+    MB_STEP(MB_H, d, a, b, c, x[ 0], 11, 0xeaa127fa); \
+    MB_STEP(MB_H, c, d, a, b, x[ 3], 16, 0xd4ef3085); \
+    MB_STEP(MB_H, b, c, d, a, x[ 6], 23,  0x4881d05); \
+    MB_STEP(MB_H, a, b, c, d, x[ 9],  4, 0xd9d4d039); \
+    MB_STEP(MB_H, d, a, b, c, x[12], 11, 0xe6db99e5); \
+    MB_STEP(MB_H, c, d, a, b, x[15], 16, 0x1fa27cf8); \
+    MB_STEP(MB_H, b, c, d, a, x[ 2], 23, 0xc4ac5665); \
+    MB_STEP(MB_I, a, b, c, d, x[ 0],  6, 0xf4292244); \
+    MB_STEP(MB_I, d, a, b, c, x[ 7], 10, 0x432aff97); \
+    MB_STEP(MB_I, c, d, a, b, x[14], 15, 0xab9423a7); \
+    MB_STEP(MB_I, b, c, d, a, x[ 5], 21, 0xfc93a039); \
+    MB_STEP(MB_I, a, b, c, d, x[12],  6, 0x655b59c3); \
+    MB_STEP(MB_I, d, a, b, c, x[ 3], 10, 0x8f0ccc92); \
+    MB_STEP(MB_I, c, d, a, b, x[10], 15, 0xffeff47d); \
+    MB_STEP(MB_I, b, c, d, a, x[ 1], 21, 0x85845dd1); \
+    MB_STEP(MB_I, a, b, c, d, x[ 8],  6, 0x6fa87e4f); \
+    MB_STEP(MB_I, d, a, b, c, x[15], 10, 0xfe2ce6e0); \
+    MB_STEP(MB_I, c, d, a, b, x[ 6], 15, 0xa3014314); \
+    MB_STEP(MB_I, b, c, d, a, x[13], 21, 0x4e0811a1); \
+    MB_STEP(MB_I, a, b, c, d, x[ 4],  6, 0xf7537e82); \
+    MB_STEP(MB_I, d, a, b, c, x[11], 10, 0xbd3af235); \
+    MB_STEP(MB_I, c, d, a, b, x[ 2], 15, 0x2ad7d2bb); \
+    MB_STEP(MB_I, b, c, d, a, x[ 9], 21, 0xeb86d391); \
+  }
+
+#define MB_NAME md5_blocks_sse2
+#define MB_VEC v4u32
+#define MB_LANES 4
+#define MB_TARGET "sse2"
+#include "md5_mb_engine.h"
+
+#define MB_NAME md5_blocks_avx2
+#define MB_VEC v8u32
+#define MB_LANES 8
+#define MB_TARGET "avx2"
+#include "md5_mb_engine.h"
+
+#define MB_NAME md5_blocks_avx512
+#define MB_VEC v16u32
+#define MB_LANES 16
+#define MB_TARGET "avx512f"
+#include "md5_mb_engine.h"
+
+typedef void (*md5_blocks_fn)(MD5_CTX *[], const uint8_t *[], const uint32_t [], unsigned int);
+
+/* Picks the widest engine this CPU runs, capped by MD5_MB_LANES. NULL
+   means scalar. */
+static md5_blocks_fn md5_select_engine(void)
+{
+  const char *env = getenv("MD5_MB_LANES");
+  int max_lanes = env ? atoi(env) : 16;
+
+  __builtin_cpu_init();
+  if (max_lanes >= 16 && __builtin_cpu_supports("avx512f"))
+    return md5_blocks_avx512;
+  if (max_lanes >= 8 && __builtin_cpu_supports("avx2"))
+    return md5_blocks_avx2;
+  if (max_lanes >= 4 && __builtin_cpu_supports("sse2"))
+    return md5_blocks_sse2;
+  return NULL;
+}
+
+/* Nonzero if no context appears twice in ctxs[]. Lanes hash from a copy of
+  their context's state, so a repeated context must go the scalar way. */
+static int md5_distinct(MD5_CTX *ctxs[], unsigned int n)
+{
+  unsigned int i, j;
+
+  for (i = 1; i < n; i++)
+    for (j = 0; j < i; j++)
+      if (ctxs[i] == ctxs[j])
+        return 0;
+  return 1;
+}
+
+#endif /* MD5_MB_X86 */
+
+/* Batch update. Continues n MD5 operations: ctxs[i] absorbs lens[i] bytes
+  from inputs[i]. Equivalent to calling MD5Update on each context in turn,
+  in array order; a context listed more than once takes the scalar path. */
+void MD5UpdateN(MD5_CTX *ctxs[], const uint8_t *inputs[], const uint32_t lens[], unsigned int n)
+{
+#ifdef MD5_MB_X86
+  static int selected = 0;
+  static md5_blocks_fn engine = NULL;
+  const uint8_t **ptrs;
+  uint32_t *blocks;
+  uint32_t head, index;
+  unsigned int i;
+
+  if (!selected) {
+    engine = md5_select_engine();
+    selected = 1;
+  }
+
+  if (engine && n > 1 && md5_distinct(ctxs, n)) {
+    ptrs = malloc(n * sizeof(*ptrs));
+    blocks = malloc(n * sizeof(*blocks));
+    if (ptrs && blocks) {
+      /* Top up partial buffers so every lane starts on a block boundary. */
+      for (i = 0; i < n; i++) {
+        index = (ctxs[i]->count[0] >> 3) & 0x3F;
+        head = index ? 64 - index : 0;
+        if (head > lens[i])
+          head = lens[i];
+        MD5Update(ctxs[i], inputs[i], head);
+        ptrs[i] = inputs[i] + head;
+        blocks[i] = (lens[i] - head) >> 6;
+      }
+
+      engine(ctxs, ptrs, blocks, n);
+
+      /* Count the lane blocks, then buffer the tails. */
+      for (i = 0; i < n; i++) {
+        md5_add_count(ctxs[i], blocks[i] << 6);
+        MD5Update(ctxs[i], ptrs[i] + (blocks[i] << 6),
+                  (lens[i] - (uint32_t)(ptrs[i] - inputs[i])) & 0x3F);
+      }
+      free(ptrs);
+      free(blocks);
+      return;
+    }
+    free(ptrs);
+    free(blocks);
+  }
+#endif
+
+  {
+    unsigned int j;
+    for (j = 0; j < n; j++)
+      MD5Update(ctxs[j], inputs[j], lens[j]);
+  }
+}
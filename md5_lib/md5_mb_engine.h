@@ -0,0 +1,94 @@
+/* Multi-buffer MD5 block engine, included by md5_mb.c once per lane width.
+
+   Expects MB_NAME (function name), MB_VEC (a GCC vector of MB_LANES
+   uint32_t) and MB_TARGET (target attribute string) to be defined. Each
+   lane runs an independent message; a lane whose message runs out of
+   blocks is refilled with the next job, so uneven lengths keep the lanes
+   busy until the queue drains. Only whole 64-byte blocks are processed
+   here; md5_mb.c handles buffering and the bit counts. */
+
+__attribute__((target(MB_TARGET)))
+static void MB_NAME(MD5_CTX *ctxs[], const uint8_t *ptrs[], const uint32_t blocks[], unsigned int n)
+{
+  uint32_t st[4][MB_LANES] __attribute__((aligned(64)));
+  uint32_t w[16][MB_LANES] __attribute__((aligned(64)));
+  const uint8_t *lane_ptr[MB_LANES];
+  uint32_t lane_left[MB_LANES];
+  int lane_job[MB_LANES];
+  unsigned int next = 0, l, k;
+  int active;
+  MB_VEC a, b, c, d, aa, bb, cc, dd, x[16];
+
+  for (l = 0; l < MB_LANES; l++)
+    lane_job[l] = -1;
+  memset(st, 0, sizeof(st));
+
+  for (;;) {
+    /* Refill idle lanes from the job queue. */
+    active = 0;
+    for (l = 0; l < MB_LANES; l++) {
+      while (lane_job[l] < 0 && next < n) {
+        if (blocks[next] != 0) {
+          lane_job[l] = (int)next;
+          lane_ptr[l] = ptrs[next];
+          lane_left[l] = blocks[next];
+          for (k = 0; k < 4; k++)
+            st[k][l] = ctxs[next]->state[k];
+        }
+        next++;
+      }
+      if (lane_job[l] >= 0)
+        active++;
+    }
+    if (!active)
+      break;
+
+    /* Gather one block per lane, word-interleaved. Idle lanes hash zeros. */
+    for (l = 0; l < MB_LANES; l++) {
+      if (lane_job[l] >= 0) {
+        for (k = 0; k < 16; k++)
+          memcpy(&w[k][l], lane_ptr[l] + 4 * k, 4);
+      } else {
+        for (k = 0; k < 16; k++)
+          w[k][l] = 0;
+      }
+    }
+    for (k = 0; k < 16; k++)
+      memcpy(&x[k], w[k], sizeof(MB_VEC));
+
+    memcpy(&a, st[0], sizeof(MB_VEC));
+    memcpy(&b, st[1], sizeof(MB_VEC));
+    memcpy(&c, st[2], sizeof(MB_VEC));
+    memcpy(&d, st[3], sizeof(MB_VEC));
+    aa = a; bb = b; cc = c; dd = d;
+
+    MB_ROUNDS(a, b, c, d, x);
+
+    a += aa; b += bb; c += cc; d += dd;
+    memcpy(st[0], &a, sizeof(MB_VEC));
+    memcpy(st[1], &b, sizeof(MB_VEC));
+    memcpy(st[2], &c, sizeof(MB_VEC));
+    memcpy(st[3], &d, sizeof(MB_VEC));
+
+    /* Retire lanes whose message is done. */
+    for (l = 0; l < MB_LANES; l++) {
+      if (lane_job[l] < 0)
+        continue;
+      lane_ptr[l] += 64;
+      if (--lane_left[l] == 0) {
+        for (k = 0; k < 4; k++)
+          ctxs[lane_job[l]]->state[k] = st[k][l];
+        lane_job[l] = -1;
+      }
+    }
+  }
+
+  /* Zeroize sensitive information. */
+  memset(w, 0, sizeof(w));
+  memset(x, 0, sizeof(x));
+}
+
+#undef MB_NAME
+#undef MB_VEC
+#undef MB_LANES
+#undef MB_TARGET
@@ -0,0 +1,87 @@
+/* REU-backed bulk hashing for the C64 (part of md5.lib, not host builds).
+
+   MD5UpdateREU hashes data that lives in a RAM Expansion Unit (1700/1764/
+   1750 or compatible, up to 16 MB) without the CPU ever copying it: the
+   REU's DMA controller fetches whole blocks into a chunk buffer and
+   MD5UpdateBlocks transforms them in place. Only the few bytes needed to
+   top up or leave a partial block go through MD5Update's buffer. */
+
+#include "md5.h"
+#include <string.h>
+
+/* REU registers */
+#define REU_COMMAND  (*(volatile uint8_t *)0xDF01)
+#define REU_C64_LO   (*(volatile uint8_t *)0xDF02)
+#define REU_C64_HI   (*(volatile uint8_t *)0xDF03)
+#define REU_ADDR_LO  (*(volatile uint8_t *)0xDF04)
+#define REU_ADDR_HI  (*(volatile uint8_t *)0xDF05)
+#define REU_BANK     (*(volatile uint8_t *)0xDF06)
+#define REU_LEN_LO   (*(volatile uint8_t *)0xDF07)
+#define REU_LEN_HI   (*(volatile uint8_t *)0xDF08)
+#define REU_ADDR_CTL (*(volatile uint8_t *)0xDF0A)
+
+/* Execute now (no $FF00 trigger), REU -> C64 */
+#define REU_CMD_FETCH 0x91
+
+/* Bytes per DMA: four MD5 blocks. The DMA itself takes one cycle per
+   byte with the CPU halted, so a larger chunk only saves register
+   setup; double buffering would gain nothing since DMA and CPU cannot
+   run at the same time. */
+#define MD5_REU_CHUNK 256
+
+static uint8_t chunk[MD5_REU_CHUNK];
+
+/* Copies len (1..65535) bytes from REU address src to dst. */
+static void ReuFetch(uint8_t *dst, uint32_t src, unsigned int len)
+{
+  REU_C64_LO = (uint8_t)((unsigned int)dst & 0xFF);
+  REU_C64_HI = (uint8_t)((unsigned int)dst >> 8);
+  REU_ADDR_LO = (uint8_t)(src & 0xFF);
+  REU_ADDR_HI = (uint8_t)((src >> 8) & 0xFF);
+  REU_BANK = (uint8_t)((src >> 16) & 0xFF);
+  REU_LEN_LO = (uint8_t)(len & 0xFF);
+  REU_LEN_HI = (uint8_t)(len >> 8);
+  REU_ADDR_CTL = 0;             /* increment both addresses */
+  REU_COMMAND = REU_CMD_FETCH;  /* CPU resumes when the copy is done */
+}
+
+/* MD5 update from REU memory. Continues an MD5 operation with inputLen
+  bytes starting at REU address reu_addr; equivalent to MD5Update on the
+  same bytes in main RAM. */
+void MD5UpdateREU(MD5_CTX *context, uint32_t reu_addr, uint32_t inputLen)
+{
+  unsigned int n, index;
+
+  /* Top up a partly filled block first */
+  index = (unsigned int)((context->count[0] >> 3) & 0x3F);
+  if (index != 0 && inputLen != 0) {
+    n = 64 - index;
+    if (n > inputLen)
+      n = (unsigned int)inputLen;
+    ReuFetch(chunk, reu_addr, n);
+    MD5Update(context, chunk, n);
+    reu_addr += n;
+    inputLen -= n;
+  }
+
+  /* Whole blocks: DMA straight into the chunk and transform in place */
+  while (inputLen >= 64) {
+    if (inputLen >= MD5_REU_CHUNK)
+      n = MD5_REU_CHUNK;
+    else
+      n = (unsigned int)inputLen & ~0x3F;
+    ReuFetch(chunk, reu_addr, n);
+    MD5UpdateBlocks(context, chunk, n >> 6);
+    reu_addr += n;
+    inputLen -= n;
+  }
+
+  /* Buffer the tail */
+  if (inputLen != 0) {
+    ReuFetch(chunk, reu_addr, (unsigned int)inputLen);
+    MD5Update(context, chunk, inputLen);
+  }
+
+  /* Zeroize sensitive information. */
+  memset(chunk, 0, sizeof(chunk));
+}
@@ -0,0 +1,284 @@
+;
+; MD5Transform for the 6502 (ca65).
+;
+; Drop-in replacement for the C MD5Transform in md5.c, selected with
+; "make MD5_TRANSFORM=asm". Called from MD5Update as
+;
+;   void __fastcall__ MD5Transform(uint32_t state[4], const uint8_t block[64]);
+;
+; The working registers a, b, c, d and the sixteen message words x[0..15]
+; live in zero page for the whole block, so every 32-bit add is a
+; LDA/ADC/STA chain on zp and every rotation is a fixed byte rename plus at
+; most four single-bit shifts. Decode is a plain copy: MD5 and the 6502 are
+; both little-endian.
+;
+; Zero page: MD5_ZP_SIZE bytes starting at MD5_ZP_BASE ($22-$72 by default,
+; BASIC's temporary and pointer area, below CHRGET). The KERNAL IRQ handler
+; does not touch it. The previous contents are saved on entry and restored
+; on exit so that BASIC survives after the program returns; programs that
+; never return to BASIC can assemble with -D MD5_ZP_NOSAVE to skip the
+; ~2300 cycle save/restore per block.
+;
+
+        .export         _MD5Transform
+        .import         popax
+        .include        "zeropage.inc"
+
+.ifndef MD5_ZP_BASE
+MD5_ZP_BASE     = $22
+.endif
+
+st_a            = MD5_ZP_BASE           ; 4 bytes each, lsb first
+st_b            = MD5_ZP_BASE + 4
+st_c            = MD5_ZP_BASE + 8
+st_d            = MD5_ZP_BASE + 12
+rtmp            = MD5_ZP_BASE + 16      ; 1 byte scratch for the final add
+msg             = MD5_ZP_BASE + 17      ; x[0..15], 64 bytes
+MD5_ZP_SIZE     = 17 + 64
+
+; Round functions, one byte at a time. None of these touch the carry flag,
+; so they can sit inside an ADC chain.
+F_FUNC          = 0
+G_FUNC          = 1
+H_FUNC          = 2
+I_FUNC          = 3
+
+.macro  fbyte   func, vb, vc, vd
+  .if func = F_FUNC                     ; d ^ (b & (c ^ d))
+        lda     vc
+        eor     vd
+        and     vb
+        eor     vd
+  .elseif func = G_FUNC                 ; c ^ (d & (b ^ c))
+        lda     vb
+        eor     vc
+        and     vd
+        eor     vc
+  .elseif func = H_FUNC                 ; b ^ c ^ d
+        lda     vb
+        eor     vc
+        eor     vd
+  .else                                 ; c ^ (b | ~d)
+        lda     vd
+        eor     #$FF
+        ora     vb
+        eor     vc
+  .endif
+.endmacro
+
+; Rotate a 32-bit zp value one bit left / right in place.
+.macro  rol1    va
+        lda     va+3
+        asl     a
+        rol     va+0
+        rol     va+1
+        rol     va+2
+        rol     va+3
+.endmacro
+
+.macro  ror1    va
+        lda     va+0
+        lsr     a
+        ror     va+3
+        ror     va+2
+        ror     va+1
+        ror     va+0
+.endmacro
+
+; One MD5 step: va = vb + ROTATE_LEFT(va + f(vb, vc, vd) + x[k] + ac, s).
+;
+; The rotation by s is split into a byte rotation of q = (s + 3) / 8 and a
+; bit rotation of s - 8q, so at most four single-bit shifts are needed
+; (left for s mod 8 <= 4, right otherwise). Bit and byte rotations commute,
+; so the bit part is done in place and the byte part is folded into the
+; final "+ vb" by reading va's bytes at an offset.
+.macro  step    func, va, vb, vc, vd, k, s, ac
+        clc
+  .repeat 4, I
+        lda     va+I
+        adc     msg+4*(k)+I
+        sta     va+I
+  .endrep
+        clc
+  .repeat 4, I
+        lda     va+I
+        adc     #(((ac) >> (8*I)) & $FF)
+        sta     va+I
+  .endrep
+        clc
+  .repeat 4, I
+        fbyte   func, vb+I, vc+I, vd+I
+        adc     va+I
+        sta     va+I
+  .endrep
+  .if ((s) .mod 8) <= 4
+    .repeat (s) .mod 8
+        rol1    va
+    .endrep
+  .else
+    .repeat 8 - ((s) .mod 8)
+        ror1    va
+    .endrep
+  .endif
+  .if (((s) + 3) / 8) & 3 = 0
+        clc
+    .repeat 4, I
+        lda     va+I
+        adc     vb+I
+        sta     va+I
+    .endrep
+  .else
+        ; va[i] = rot[(i - q) & 3] + vb[i]; hold results in X, Y and rtmp
+        ; until every source byte has been read.
+        clc
+        lda     va+((0 - ((s) + 3) / 8) & 3)
+        adc     vb+0
+        tax
+        lda     va+((1 - ((s) + 3) / 8) & 3)
+        adc     vb+1
+        tay
+        lda     va+((2 - ((s) + 3) / 8) & 3)
+        adc     vb+2
+        sta     rtmp
+        lda     va+((3 - ((s) + 3) / 8) & 3)
+        adc     vb+3
+        sta     va+3
+        lda     rtmp
+        sta     va+2
+        stx     va+0
+        sty     va+1
+  .endif
+.endmacro
+
+.segment        "BSS"
+
+.ifndef MD5_ZP_NOSAVE
+zpsave:         .res    MD5_ZP_SIZE
+.endif
+
+.segment        "CODE"
+
+.proc   _MD5Transform
+
+        sta     ptr1                    ; block
+        stx     ptr1+1
+        jsr     popax
+        sta     ptr2                    ; state
+        stx     ptr2+1
+
+.ifndef MD5_ZP_NOSAVE
+        ldx     #MD5_ZP_SIZE-1
+@save:  lda     MD5_ZP_BASE,x
+        sta     zpsave,x
+        dex
+        bpl     @save
+.endif
+
+        ldy     #63                     ; Decode: x[] = block[]
+@copy:  lda     (ptr1),y
+        sta     msg,y
+        dey
+        bpl     @copy
+
+        ldy     #15                     ; a, b, c, d = state[]
+@load:  lda     (ptr2),y
+        sta     st_a,y
+        dey
+        bpl     @load
+
+        ; Round 1
+        step    F_FUNC, st_a, st_b, st_c, st_d,  0,  7, $d76aa478
+        step    F_FUNC, st_d, st_a, st_b, st_c,  1, 12, $e8c7b756
+        step    F_FUNC, st_c, st_d, st_a, st_b,  2, 17, $242070db
+        step    F_FUNC, st_b, st_c, st_d, st_a,  3, 22, $c1bdceee
+        step    F_FUNC, st_a, st_b, st_c, st_d,  4,  7, $f57c0faf
+        step    F_FUNC, st_d, st_a, st_b, st_c,  5, 12, $4787c62a
+        step    F_FUNC, st_c, st_d, st_a, st_b,  6, 17, $a8304613
+        step    F_FUNC, st_b, st_c, st_d, st_a,  7, 22, $fd469501
+        step    F_FUNC, st_a, st_b, st_c, st_d,  8,  7, $698098d8
+        step    F_FUNC, st_d, st_a, st_b, st_c,  9, 12, $8b44f7af
+        step    F_FUNC, st_c, st_d, st_a, st_b, 10, 17, $ffff5bb1
+        step    F_FUNC, st_b, st_c, st_d, st_a, 11, 22, $895cd7be
+        step    F_FUNC, st_a, st_b, st_c, st_d, 12,  7, $6b901122
+        step    F_FUNC, st_d, st_a, st_b, st_c, 13, 12, $fd987193
+        step    F_FUNC, st_c, st_d, st_a, st_b, 14, 17, $a679438e
+        step    F_FUNC, st_b, st_c, st_d, st_a, 15, 22, $49b40821
+
+        ; Round 2
+        step    G_FUNC, st_a, st_b, st_c, st_d,  1,  5, $f61e2562
+        step    G_FUNC, st_d, st_a, st_b, st_c,  6,  9, $c040b340
+        step    G_FUNC, st_c, st_d, st_a, st_b, 11, 14, $265e5a51
+        step    G_FUNC, st_b, st_c, st_d, st_a,  0, 20, $e9b6c7aa
+        step    G_FUNC, st_a, st_b, st_c, st_d,  5,  5, $d62f105d
+        step    G_FUNC, st_d, st_a, st_b, st_c, 10,  9, $02441453
+        step    G_FUNC, st_c, st_d, st_a, st_b, 15, 14, $d8a1e681
+        step    G_FUNC, st_b, st_c, st_d, st_a,  4, 20, $e7d3fbc8
+        step    G_FUNC, st_a, st_b, st_c, st_d,  9,  5, $21e1cde6
+        step    G_FUNC, st_d, st_a, st_b, st_c, 14,  9, $c33707d6
+        step    G_FUNC, st_c, st_d, st_a, st_b,  3, 14, $f4d50d87
+        step    G_FUNC, st_b, st_c, st_d, st_a,  8, 20, $455a14ed
+        step    G_FUNC, st_a, st_b, st_c, st_d, 13,  5, $a9e3e905
+        step    G_FUNC, st_d, st_a, st_b, st_c,  2,  9, $fcefa3f8
+        step    G_FUNC, st_c, st_d, st_a, st_b,  7, 14, $676f02d9
+        step    G_FUNC, st_b, st_c, st_d, st_a, 12, 20, $8d2a4c8a
+
+        ; Round 3
+        step    H_FUNC, st_a, st_b, st_c, st_d,  5,  4, $fffa3942
+        step    H_FUNC, st_d, st_a, st_b, st_c,  8, 11, $8771f681
+        step    H_FUNC, st_c, st_d, st_a, st_b, 11, 16, $6d9d6122
+        step    H_FUNC, st_b, st_c, st_d, st_a, 14, 23, $fde5380c
+        step    H_FUNC, st_a, st_b, st_c, st_d,  1,  4, $a4beea44
+        step    H_FUNC, st_d, st_a, st_b, st_c,  4, 11, $4bdecfa9
+        step    H_FUNC, st_c, st_d, st_a, st_b,  7, 16, $f6bb4b60
+        step    H_FUNC, st_b, st_c, st_d, st_a, 10, 23, $bebfbc70
+        step    H_FUNC, st_a, st_b, st_c, st_d, 13,  4, $289b7ec6
+        step    H_FUNC, st_d, st_a, st_b, st_c,  0, 11, $eaa127fa
+        step    H_FUNC, st_c, st_d, st_a, st_b,  3, 16, $d4ef3085
+        step    H_FUNC, st_b, st_c, st_d, st_a,  6, 23, $04881d05
+        step    H_FUNC, st_a, st_b, st_c, st_d,  9,  4, $d9d4d039
+        step    H_FUNC, st_d, st_a, st_b, st_c, 12, 11, $e6db99e5
+        step    H_FUNC, st_c, st_d, st_a, st_b, 15, 16, $1fa27cf8
+        step    H_FUNC, st_b, st_c, st_d, st_a,  2, 23, $c4ac5665
+
+        ; Round 4
+        step    I_FUNC, st_a, st_b, st_c, st_d,  0,  6, $f4292244
+        step    I_FUNC, st_d, st_a, st_b, st_c,  7, 10, $432aff97
+        step    I_FUNC, st_c, st_d, st_a, st_b, 14, 15, $ab9423a7
+        step    I_FUNC, st_b, st_c, st_d, st_a,  5, 21, $fc93a039
+        step    I_FUNC, st_a, st_b, st_c, st_d, 12,  6, $655b59c3
+        step    I_FUNC, st_d, st_a, st_b, st_c,  3, 10, $8f0ccc92
+        step    I_FUNC, st_c, st_d, st_a, st_b, 10, 15, $ffeff47d
+        step    I_FUNC, st_b, st_c, st_d, st_a,  1, 21, $85845dd1
+        step    I_FUNC, st_a, st_b, st_c, st_d,  8,  6, $6fa87e4f
+        step    I_FUNC, st_d, st_a, st_b, st_c, 15, 10, $fe2ce6e0
+        step    I_FUNC, st_c, st_d, st_a, st_b,  6, 15, $a3014314
+        step    I_FUNC, st_b, st_c, st_d, st_a, 13, 21, $4e0811a1
+        step    I_FUNC, st_a, st_b, st_c, st_d,  4,  6, $f7537e82
+        step    I_FUNC, st_d, st_a, st_b, st_c, 11, 10, $bd3af235
+        step    I_FUNC, st_c, st_d, st_a, st_b,  2, 15, $2ad7d2bb
+        step    I_FUNC, st_b, st_c, st_d, st_a,  9, 21, $eb86d391
+
+        ldy     #0                      ; state[] += a, b, c, d
+  .repeat 16, I
+    .if (I & 3) = 0
+        clc
+    .endif
+        lda     (ptr2),y
+        adc     st_a+I
+        sta     (ptr2),y
+    .if I < 15
+        iny
+    .endif
+  .endrep
+
+.ifndef MD5_ZP_NOSAVE
+        ldx     #MD5_ZP_SIZE-1          ; also wipes x[] and a..d
+@rest:  lda     zpsave,x
+        sta     MD5_ZP_BASE,x
+        dex
+        bpl     @rest
+.endif
+
+        rts
+
+.endproc
@@ -0,0 +1,206 @@
+// md5sum for the C64: hashes files on a 1541/SD2IEC drive.
+//
+//   RUN:REM NAME [DEVICE]   hash one file
+//   RUN:REM * [DEVICE]      hash every PRG/SEQ/USR file in the directory
+//   RUN                     prompt for a name (device 8)
+//
+// Files are streamed through MD5Update in sector-sized chunks, so memory
+// use does not depend on file size. Each line reports the digest, the byte
+// count and the throughput in bytes/second.
+
+#include <cbm.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "md5.h"
+
+#define FILE_LFN    2
+#define DIR_LFN     3
+#define CMD_LFN     15
+#define DEFAULT_DEV 8
+
+// 256 bytes: about one sector, and a whole number of MD5 blocks so full
+// chunks are transformed straight from buf without staging.
+#define CHUNK       256
+#define MAX_FILES   144     // 1541 directory limit
+#define MAX_NAME    16      // CBM file name length
+
+static unsigned char buf[CHUNK];
+static char names[MAX_FILES][MAX_NAME + 1];
+static unsigned char types[MAX_FILES];
+static char open_name[MAX_NAME + 5];  // name plus ",p,r"
+static char status[40];
+
+static unsigned long total_bytes = 0;
+static int failures = 0;
+
+// Read the drive's error channel. Returns the DOS status code (0 = OK).
+int drive_status(unsigned char dev) {
+    int n;
+
+    if (cbm_open(CMD_LFN, dev, 15, "") != 0) {
+        strcpy(status, "device not present");
+        return 99;
+    }
+    n = cbm_read(CMD_LFN, status, sizeof(status) - 1);
+    cbm_close(CMD_LFN);
+    if (n <= 0) {
+        strcpy(status, "no status");
+        return 99;
+    }
+    status[n] = 0;
+    if (status[n - 1] == '\r')
+        status[n - 1] = 0;
+    return atoi(status);
+}
+
+void print_digest(unsigned char *digest) {
+    int i;
+    for(i = 0; i < 16; i++) {
+        printf("%02x", digest[i]);
+    }
+}
+
+void hash_file(const char *name, unsigned char type, unsigned char dev) {
+    MD5_CTX context;
+    unsigned char digest[16];
+    unsigned long bytes = 0;
+    clock_t start, ticks;
+    int n;
+
+    if (strlen(name) > MAX_NAME) {
+        printf("%s\n  error: name longer than %d\n", name, MAX_NAME);
+        failures++;
+        return;
+    }
+
+    // Open with an explicit type when we know it from the directory
+    strcpy(open_name, name);
+    switch (type) {
+        case CBM_T_SEQ: strcat(open_name, ",s"); break;
+        case CBM_T_USR: strcat(open_name, ",u"); break;
+        case CBM_T_PRG: strcat(open_name, ",p"); break;
+    }
+    strcat(open_name, ",r");
+
+    printf("%s\n", name);
+    if (cbm_open(FILE_LFN, dev, 2, open_name) != 0) {
+        // Nothing to close; the error channel may still say why
+        if (drive_status(dev) == 0)
+            strcpy(status, "open failed");
+        printf("  error: %s\n", status);
+        failures++;
+        return;
+    }
+    if (drive_status(dev) != 0) {
+        cbm_close(FILE_LFN);
+        printf("  error: %s\n", status);
+        failures++;
+        return;
+    }
+
+    MD5Init(&context);
+    start = clock();
+
+    // The serial bus is bit-banged by the CPU, so reading and hashing
+    // cannot overlap; the best we can do is keep the per-chunk overhead low.
+    while ((n = cbm_read(FILE_LFN, buf, CHUNK)) > 0) {
+        MD5Update(&context, buf, (uint32_t)n);
+        bytes += n;
+    }
+
+    ticks = clock() - start;
+    cbm_close(FILE_LFN);
+
+    if (n < 0) {
+        drive_status(dev);
+        printf("  read error: %s\n", status);
+        failures++;
+        return;
+    }
+
+    MD5Final(digest, &context);
+
+    printf("  ");
+    print_digest(digest);
+    printf("\n  %lu bytes", bytes);
+    if (ticks != 0)
+        printf(", %lu b/s", bytes * CLOCKS_PER_SEC / ticks);
+    printf("\n");
+
+    total_bytes += bytes;
+}
+
+// Collect PRG/SEQ/USR names first: the 1541 cannot stream a file while
+// the directory channel is still open.
+int read_directory(unsigned char dev) {
+    struct cbm_dirent entry;
+    int count = 0;
+
+    if (cbm_opendir(DIR_LFN, dev) != 0) {
+        drive_status(dev);
+        printf("directory error: %s\n", status);
+        return -1;
+    }
+    while (count < MAX_FILES && cbm_readdir(DIR_LFN, &entry) == 0) {
+        if (entry.type == CBM_T_PRG || entry.type == CBM_T_SEQ ||
+            entry.type == CBM_T_USR) {
+            strcpy(names[count], entry.name);
+            types[count] = entry.type;
+            count++;
+        }
+    }
+    cbm_closedir(DIR_LFN);
+    return count;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned char dev = DEFAULT_DEV;
+    const char *pattern;
+    clock_t start, ticks;
+    int i, count;
+
+    printf("md5sum\n");
+    printf("------\n");
+
+    if (argc > 1) {
+        pattern = argv[1];
+        if (argc > 2)
+            dev = (unsigned char)atoi(argv[2]);
+    } else {
+        printf("file (* = all): ");
+        if (fgets(open_name, sizeof(open_name), stdin) == NULL)
+            return 1;
+        open_name[strcspn(open_name, "\r\n")] = 0;
+        if (strlen(open_name) > MAX_NAME) {
+            printf("name longer than %d\n", MAX_NAME);
+            return 1;
+        }
+        strcpy(names[0], open_name);
+        pattern = names[0];
+    }
+
+    start = clock();
+
+    if (strcmp(pattern, "*") == 0) {
+        count = read_directory(dev);
+        if (count < 0)
+            return 1;
+        for (i = 0; i < count; i++) {
+            hash_file(names[i], types[i], dev);
+        }
+    } else {
+        hash_file(pattern, 0, dev);
+    }
+
+    ticks = clock() - start;
+    printf("\ntotal %lu bytes", total_bytes);
+    if (ticks != 0)
+        printf(", %lu b/s", total_bytes * CLOCKS_PER_SEC / ticks);
+    printf("\n");
+    if (failures != 0)
+        printf("%d files failed.\n", failures);
+
+    return failures != 0;
+}